@@ -5,9 +5,14 @@
 #include <Eigen/StdVector>
 #include <Eigen/Geometry>
 #include <sim_env/utils/EigenUtils.h>
+#include <sim_env/utils/ParallelUtils.h>
 #include <stdexcept>
 #include <ostream>
 #include <algorithm>
+#include <array>
+#include <cmath>
+#include <cstdint>
+#include <type_traits>
 
 namespace sim_env {
     namespace grid {
@@ -238,18 +243,143 @@ namespace sim_env {
                 }
         };
 
+        /**
+         * The following layout policies define how a Grid3D maps a cell index (x, y, z) to a position in its
+         * underlying storage. A layout policy provides
+         *  size_t reset(x_size, y_size, z_size) - adapts the layout to the given grid size and returns the
+         *                                         number of storage elements required
+         *  size_t getIndex(x, y, z) const       - returns the storage position of cell (x, y, z)
+         * The public indexing API of a grid is independent of its layout. The layout only affects
+         * which cells are close to each other in memory.
+         */
+
+        /**
+         * Plain row-major layout, i.e. cells along the x axis are contiguous in memory.
+         */
+        struct RowMajorLayout {
+            size_t _x_size;
+            size_t _xy_stride;
+
+            size_t reset(const size_t& x_size, const size_t& y_size, const size_t& z_size) {
+                _x_size = x_size;
+                _xy_stride = x_size * y_size;
+                return _xy_stride * z_size;
+            }
+
+            inline size_t getIndex(const size_t& x, const size_t& y, const size_t& z) const {
+                return x + y * _x_size + z * _xy_stride;
+            }
+        };
+
+        /**
+         * Tiled layout. The grid is partitioned into cubic tiles of TileSize^3 cells that are stored contiguously.
+         * Within a tile, and among tiles, cells are stored in row-major order. Neighboring cells in all three
+         * dimensions are thus likely to share a cache line or page. The storage is padded to full tiles.
+         */
+        template<size_t TileSize = 8>
+        struct TiledLayout {
+            static_assert(TileSize > 0 and (TileSize & (TileSize - 1)) == 0, "TileSize must be a power of two");
+            static constexpr size_t log2(size_t n) {
+                return n <= 1 ? 0 : 1 + log2(n / 2);
+            }
+            static constexpr size_t TILE_BITS = log2(TileSize);
+            static constexpr size_t TILE_MASK = TileSize - 1;
+            size_t _x_tiles;
+            size_t _xy_tiles;
+
+            size_t reset(const size_t& x_size, const size_t& y_size, const size_t& z_size) {
+                _x_tiles = (x_size + TILE_MASK) >> TILE_BITS;
+                _xy_tiles = _x_tiles * ((y_size + TILE_MASK) >> TILE_BITS);
+                size_t num_tiles = _xy_tiles * ((z_size + TILE_MASK) >> TILE_BITS);
+                return num_tiles << (3 * TILE_BITS);
+            }
+
+            inline size_t getIndex(const size_t& x, const size_t& y, const size_t& z) const {
+                size_t tile = (x >> TILE_BITS) + (y >> TILE_BITS) * _x_tiles + (z >> TILE_BITS) * _xy_tiles;
+                size_t in_tile = (x & TILE_MASK) + ((y & TILE_MASK) << TILE_BITS) + ((z & TILE_MASK) << (2 * TILE_BITS));
+                return (tile << (3 * TILE_BITS)) + in_tile;
+            }
+        };
+
+        /**
+         * Morton (Z-order) layout. The grid is partitioned into cubic blocks whose side length is the smallest
+         * power of two that is at least the smallest dimension of the grid. Within a block, the storage position
+         * of a cell is obtained by interleaving the bits of its x, y and z index; the blocks themselves are
+         * stored in row-major order. For grids whose dimensions are all the same power of two this is the
+         * plain Morton order without any padding. Otherwise, the storage is padded by less than a factor
+         * of two per dimension. Each index may have at most 21 bits.
+         */
+        struct MortonLayout {
+            // Since blocks are stored row-major, the storage position is the sum of one term per axis,
+            // which is precomputed for each index along the axis.
+            std::vector<size_t> _x_offsets;
+            std::vector<size_t> _y_offsets;
+            std::vector<size_t> _z_offsets;
+
+            static inline uint64_t spreadBits(uint64_t v) {
+                v &= 0x1fffff;
+                v = (v | v << 32) & 0x1f00000000ffffull;
+                v = (v | v << 16) & 0x1f0000ff0000ffull;
+                v = (v | v << 8) & 0x100f00f00f00f00full;
+                v = (v | v << 4) & 0x10c30c30c30c30c3ull;
+                v = (v | v << 2) & 0x1249249249249249ull;
+                return v;
+            }
+
+            size_t reset(const size_t& x_size, const size_t& y_size, const size_t& z_size) {
+                const size_t max_size = size_t(1) << 21;
+                if (x_size > max_size or y_size > max_size or z_size > max_size) {
+                    throw std::invalid_argument("MortonLayout supports at most 2^21 cells per dimension.");
+                }
+                const size_t min_size = std::min(x_size, std::min(y_size, z_size));
+                size_t block_bits = 0;
+                while ((size_t(1) << block_bits) < min_size) {
+                    ++block_bits;
+                }
+                const size_t block_mask = (size_t(1) << block_bits) - 1;
+                const size_t x_blocks = (x_size + block_mask) >> block_bits;
+                const size_t xy_blocks = x_blocks * ((y_size + block_mask) >> block_bits);
+                _x_offsets.resize(x_size);
+                _y_offsets.resize(y_size);
+                _z_offsets.resize(z_size);
+                for (size_t x = 0; x < x_size; ++x) {
+                    _x_offsets[x] = ((x >> block_bits) << (3 * block_bits)) + spreadBits(x & block_mask);
+                }
+                for (size_t y = 0; y < y_size; ++y) {
+                    _y_offsets[y] = (((y >> block_bits) * x_blocks) << (3 * block_bits)) +
+                                    (spreadBits(y & block_mask) << 1);
+                }
+                for (size_t z = 0; z < z_size; ++z) {
+                    _z_offsets[z] = (((z >> block_bits) * xy_blocks) << (3 * block_bits)) +
+                                    (spreadBits(z & block_mask) << 2);
+                }
+                if (min_size == 0) {
+                    return 0;
+                }
+                // the last cell has the largest index, cells after it in its block are never used
+                return getIndex(x_size - 1, y_size - 1, z_size - 1) + 1;
+            }
+
+            inline size_t getIndex(const size_t& x, const size_t& y, const size_t& z) const {
+                return _x_offsets[x] + _y_offsets[y] + _z_offsets[z];
+            }
+        };
+
         /*
             * A simple implementation of a 3D grid that stores values of type ValueType. ValueType can be
             * any type that can be stored in a std::vector. NOTE that there is only limited support for Eigen
             * types. For currently supported types check the definition of vector_type below.
+            * The Layout policy defines how cells are arranged in memory (see RowMajorLayout above).
+            * NOTE: begin()/end() iterate over the underlying storage, i.e. in layout order. For layouts other than
+            * RowMajorLayout this order differs from the order of an IndexGenerator and may include padding cells.
             */
-        template <typename ValueType>
+        template <typename ValueType, typename Layout = RowMajorLayout>
         class Grid3D {
             public:
-                template<typename ValueType1>
-                friend std::ostream& operator<<(std::ostream& os, Grid3D<ValueType1> const& grid);
-                template<typename ValueType1>
-                friend std::istream& operator>>(std::istream& is, Grid3D<ValueType1>& grid);
+                template<typename ValueType1, typename Layout1>
+                friend std::ostream& operator<<(std::ostream& os, Grid3D<ValueType1, Layout1> const& grid);
+                template<typename ValueType1, typename Layout1>
+                friend std::istream& operator>>(std::istream& is, Grid3D<ValueType1, Layout1>& grid);
             private:
                 typedef typename std::conditional<std::is_same<ValueType, Eigen::Vector4f>::value or
                                          std::is_same<ValueType, Eigen::Matrix2f>::value or
@@ -261,10 +391,7 @@ namespace sim_env {
                 size_t _x_size;
                 size_t _y_size;
                 size_t _z_size;
-                size_t _xy_stride;
-                inline size_t getFlatIndex(const size_t& x, const size_t& y, const size_t& z) const {
-                    return x + y * _x_size + z * _xy_stride;
-                }
+                Layout _layout;
             protected:
                 /*
                     * Reset this grid to a new size.
@@ -275,24 +402,52 @@ namespace sim_env {
                     _x_size = new_x;
                     _y_size = new_y;
                     _z_size = new_z;
-                    _xy_stride = _x_size * _y_size;
-                    _values.resize(_x_size * _y_size * _z_size, default_value);
+                    _values.resize(_layout.reset(_x_size, _y_size, _z_size), default_value);
+                }
+            private:
+                // Shared implementation of the const and non-const forEachNeighbor.
+                template<typename GridType, typename Function>
+                static void forEachNeighborImpl(GridType& grid, const UnsignedIndex& idx,
+                                                const size_t& dx, const size_t& dy, const size_t& dz, Function& fn) {
+                    const size_t x_begin = idx.ix > dx ? idx.ix - dx : 0;
+                    const size_t y_begin = idx.iy > dy ? idx.iy - dy : 0;
+                    const size_t z_begin = idx.iz > dz ? idx.iz - dz : 0;
+                    const size_t x_end = std::min(idx.ix + dx + 1, grid._x_size);
+                    const size_t y_end = std::min(idx.iy + dy + 1, grid._y_size);
+                    const size_t z_end = std::min(idx.iz + dz + 1, grid._z_size);
+                    UnsignedIndex neighbor_idx;
+                    for (neighbor_idx.iz = z_begin; neighbor_idx.iz < z_end; ++neighbor_idx.iz) {
+                        for (neighbor_idx.iy = y_begin; neighbor_idx.iy < y_end; ++neighbor_idx.iy) {
+                            if (std::is_same<Layout, RowMajorLayout>::value) {
+                                // x-runs are contiguous in memory
+                                size_t flat_index = grid.getFlatIndex(x_begin, neighbor_idx.iy, neighbor_idx.iz);
+                                for (neighbor_idx.ix = x_begin; neighbor_idx.ix < x_end; ++neighbor_idx.ix) {
+                                    fn(const_cast<const UnsignedIndex&>(neighbor_idx), grid._values[flat_index++]);
+                                }
+                            } else {
+                                for (neighbor_idx.ix = x_begin; neighbor_idx.ix < x_end; ++neighbor_idx.ix) {
+                                    fn(const_cast<const UnsignedIndex&>(neighbor_idx),
+                                       grid._values[grid.getFlatIndex(neighbor_idx)]);
+                                }
+                            }
+                        }
+                    }
                 }
             public:
                 Grid3D(size_t max_x, size_t max_y, size_t max_z):
-                    _x_size(max_x), _y_size(max_y), _z_size(max_z), _xy_stride(_x_size * _y_size)
+                    _x_size(max_x), _y_size(max_y), _z_size(max_z)
                 {
-                    _values.resize(_x_size * _y_size * _z_size);
+                    _values.resize(_layout.reset(_x_size, _y_size, _z_size));
                 }
                 Grid3D(size_t max_x, size_t max_y, size_t max_z, ValueType default_value) :
-                    _x_size(max_x), _y_size(max_y), _z_size(max_z), _xy_stride(_x_size * _y_size)
+                    _x_size(max_x), _y_size(max_y), _z_size(max_z)
                 {
-                    _values.resize(_x_size * _y_size * _z_size, default_value);
+                    _values.resize(_layout.reset(_x_size, _y_size, _z_size), default_value);
                 }
 
-                Grid3D(const Grid3D<ValueType>& other) = default;
+                Grid3D(const Grid3D& other) = default;
                 ~Grid3D() = default;
-                Grid3D<ValueType>& operator=(const Grid3D<ValueType>& other) = default;
+                Grid3D& operator=(const Grid3D& other) = default;
 
                 inline size_t getXSize() const {
                     return _x_size;
@@ -322,6 +477,37 @@ namespace sim_env {
                     return inBounds(idx.ix, idx.iy, idx.iz);
                 }
 
+                /*
+                 * Returns the flat index of the given cell, i.e. its position in the underlying storage.
+                 * Flat indices remain valid as long as the grid is not reset.
+                 */
+                inline size_t getFlatIndex(const size_t& x, const size_t& y, const size_t& z) const {
+                    return _layout.getIndex(x, y, z);
+                }
+
+                inline size_t getFlatIndex(const UnsignedIndex& idx) const {
+                    return _layout.getIndex(idx.ix, idx.iy, idx.iz);
+                }
+
+                /*
+                 * Returns the number of elements in the underlying storage. Depending on the layout,
+                 * this may be larger than the number of cells.
+                 */
+                inline size_t getStorageSize() const {
+                    return _values.size();
+                }
+
+                /*
+                 * Access the value with the given flat index (see getFlatIndex).
+                 */
+                ValueType& operator[](const size_t& flat_index) {
+                    return _values[flat_index];
+                }
+
+                const ValueType& operator[](const size_t& flat_index) const {
+                    return _values[flat_index];
+                }
+
                 ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) {
                     return _values[getFlatIndex(ix, iy, iz)];
                 }
@@ -400,6 +586,28 @@ namespace sim_env {
                     return BlindBoxIndexGenerator(dx, dy, dz, idx);
                 }
 
+                /*
+                 * Calls fn(const UnsignedIndex& neighbor_idx, ValueType& value) for each cell within the box of
+                 * (2 * dx + 1) x (2 * dy + 1) x (2 * dz + 1) cells centered at idx, including idx itself.
+                 * Cells are visited in the same order as by getNeighborIndexGenerator(idx, dx, dy, dz).
+                 * The box is clipped to the grid once, so no bounds checks are performed per cell.
+                 * Prefer this over a BoxIndexGenerator in performance critical loops.
+                 */
+                template<typename Function>
+                void forEachNeighbor(const UnsignedIndex& idx, const size_t& dx, const size_t& dy, const size_t& dz,
+                                     Function fn) {
+                    forEachNeighborImpl(*this, idx, dx, dy, dz, fn);
+                }
+
+                /*
+                 * Const version of forEachNeighbor. fn is called as fn(const UnsignedIndex&, const ValueType&).
+                 */
+                template<typename Function>
+                void forEachNeighbor(const UnsignedIndex& idx, const size_t& dx, const size_t& dy, const size_t& dz,
+                                     Function fn) const {
+                    forEachNeighborImpl(*this, idx, dx, dy, dz, fn);
+                }
+
                 typename std::vector<ValueType>::iterator begin() noexcept {
                     return _values.begin();
                 }
@@ -450,8 +658,8 @@ namespace sim_env {
         };
 
         // Operator for convenient output of Grid3Ds; needs ValueType to be streamable
-        template <typename ValueType>
-        inline std::ostream& operator<<(std::ostream& os, sim_env::grid::Grid3D<ValueType> const& grid) {
+        template <typename ValueType, typename Layout>
+        inline std::ostream& operator<<(std::ostream& os, sim_env::grid::Grid3D<ValueType, Layout> const& grid) {
             os << grid.getXSize() << grid.getYSize() << grid.getZSize();
             for(const auto& value : grid) {
                 os << value;
@@ -460,8 +668,8 @@ namespace sim_env {
         }
 
         // Operator for convenient input of Grid3Ds; needs ValueType to be streamable
-        template <typename ValueType>
-        inline std::istream& operator>>(std::istream& is, sim_env::grid::Grid3D<ValueType>& grid) {
+        template <typename ValueType, typename Layout>
+        inline std::istream& operator>>(std::istream& is, sim_env::grid::Grid3D<ValueType, Layout>& grid) {
             size_t x_size;
             is >> x_size;
             size_t y_size;
@@ -476,31 +684,166 @@ namespace sim_env {
         }
 
         /**
-         * A VoxelGrid extends the functionality of Grid3D by spatial relations. Each
-         * cell of the grid represents a volume in R^3. The size of the volume is determined
-         * by the size of the voxel (which is identical in each dimension). Furthermore,
-         * a voxel grid provides a transformation from some world frame to its local frame.
+         * A GridNeighborhood provides the 6-, 18- or 26-neighborhood of cells in a grid of a given size and layout,
+         * i.e. all cells that share a face, a face or an edge, or a face, an edge or a corner with a cell.
+         * The relative offsets (including their flat index offsets for RowMajorLayout) are computed once,
+         * so that iterating over the neighbors of a cell requires no divisions and, for cells that are not at
+         * the boundary of the grid, no bounds checks. This is intended for graph searches and similar hot loops.
          */
-        template<typename ScalarType, typename ValueType>
-        class VoxelGrid : public grid::Grid3D<ValueType> {
-            EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+        template<typename Layout = RowMajorLayout>
+        class GridNeighborhood {
+            private:
+                size_t _x_size;
+                size_t _y_size;
+                size_t _z_size;
+                Layout _layout;
+                std::vector<SignedIndex> _offsets;
+                std::vector<long> _flat_offsets;
+                std::vector<double> _offset_lengths;
             public:
-                template<typename ScalarType1, typename ValueType1>
-                friend std::ostream& operator<<(std::ostream& os, VoxelGrid<ScalarType1, ValueType1> const& grid);
-                template<typename ScalarType1, typename ValueType1>
-                friend std::istream& operator>>(std::istream& is, VoxelGrid<ScalarType1, ValueType1>& grid);
+                /*
+                 * Creates the neighborhood for a grid with the given size.
+                 * @param connectivity - either 6, 18 or 26
+                 */
+                GridNeighborhood(const size_t& x_size, const size_t& y_size, const size_t& z_size,
+                                 unsigned int connectivity = 26) :
+                    _x_size(x_size), _y_size(y_size), _z_size(z_size)
+                {
+                    if (connectivity != 6 and connectivity != 18 and connectivity != 26) {
+                        throw std::invalid_argument("The connectivity of a grid neighborhood must be 6, 18 or 26.");
+                    }
+                    _layout.reset(x_size, y_size, z_size);
+                    // max number of non-zero offset components
+                    long max_non_zero = connectivity == 6 ? 1 : (connectivity == 18 ? 2 : 3);
+                    for (long oz = -1; oz <= 1; ++oz) {
+                        for (long oy = -1; oy <= 1; ++oy) {
+                            for (long ox = -1; ox <= 1; ++ox) {
+                                long non_zero = std::abs(ox) + std::abs(oy) + std::abs(oz);
+                                if (non_zero == 0 or non_zero > max_non_zero) continue;
+                                _offsets.push_back(SignedIndex(ox, oy, oz));
+                                _flat_offsets.push_back(ox + oy * (long)x_size + oz * (long)(x_size * y_size));
+                                _offset_lengths.push_back(std::sqrt((double)non_zero));
+                            }
+                        }
+                    }
+                }
+
+                template<typename ValueType>
+                GridNeighborhood(const Grid3D<ValueType, Layout>& grid, unsigned int connectivity = 26) :
+                    GridNeighborhood(grid.getXSize(), grid.getYSize(), grid.getZSize(), connectivity) {}
+
+                /*
+                 * Returns the number of neighbors of a cell that is not at the boundary of the grid.
+                 */
+                size_t size() const {
+                    return _offsets.size();
+                }
+
+                const SignedIndex& getOffset(const size_t& i) const {
+                    return _offsets[i];
+                }
+
+                /*
+                 * Returns the Euclidean length of the i-th offset in cells, i.e. 1, sqrt(2) or sqrt(3).
+                 */
+                double getOffsetLength(const size_t& i) const {
+                    return _offset_lengths[i];
+                }
+
+                /*
+                 * Calls fn(size_t i, const UnsignedIndex& neighbor_idx, size_t neighbor_flat_index) for each neighbor
+                 * of the cell idx that lies within the grid, where i is the index of the offset
+                 * (see getOffset(i)) and neighbor_flat_index the flat index of the neighbor (see Grid3D::getFlatIndex).
+                 */
+                template<typename Function>
+                void forEach(const UnsignedIndex& idx, Function fn) const {
+                    const bool interior = idx.ix > 0 and idx.iy > 0 and idx.iz > 0 and
+                        idx.ix + 1 < _x_size and idx.iy + 1 < _y_size and idx.iz + 1 < _z_size;
+                    const bool row_major = std::is_same<Layout, RowMajorLayout>::value;
+                    const long flat_index = row_major ? (long)_layout.getIndex(idx.ix, idx.iy, idx.iz) : 0;
+                    for (size_t i = 0; i < _offsets.size(); ++i) {
+                        const SignedIndex& offset = _offsets[i];
+                        UnsignedIndex neighbor_idx(idx.ix + offset.ix, idx.iy + offset.iy, idx.iz + offset.iz);
+                        // out of range indices wrap around to large unsigned values
+                        if (not interior and (neighbor_idx.ix >= _x_size or neighbor_idx.iy >= _y_size or
+                                              neighbor_idx.iz >= _z_size)) {
+                            continue;
+                        }
+                        if (row_major) {
+                            fn(i, const_cast<const UnsignedIndex&>(neighbor_idx), (size_t)(flat_index + _flat_offsets[i]));
+                        } else {
+                            fn(i, const_cast<const UnsignedIndex&>(neighbor_idx),
+                               _layout.getIndex(neighbor_idx.ix, neighbor_idx.iy, neighbor_idx.iz));
+                        }
+                    }
+                }
+        };
+
+        /**
+         * A VoxelGridMapping describes the spatial relations of a voxel grid, i.e. the local axis aligned
+         * bounding box, the size of a voxel (which is identical in each dimension) and the transformation
+         * from some world frame to the local frame of the grid. It does not store any values, so that
+         * different voxel grid implementations can share the same mapping from positions to indices.
+         */
+        template<typename ScalarType>
+        class VoxelGridMapping {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
                 typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+                typedef Eigen::Transform<ScalarType, 3, Eigen::Affine> Transform;
+                typedef Eigen::Matrix<ScalarType, 3, 4> AffineMatrix;
             private:
                 ScalarType _cell_size;
-                Eigen::Transform<ScalarType, 3, Eigen::Affine> _transform;
-                Eigen::Transform<ScalarType, 3, Eigen::Affine> _inv_transform;
+                Transform _transform;
+                Transform _inv_transform;
                 Vector3s _min_point;
                 Vector3s _max_point;
                 std::array<size_t, 3> _num_cells;
-            protected:
-                void resetVoxelGrid(const Vector3s& min_point, const Vector3s& max_point,
-                            const ScalarType& cell_size, ValueType default_value=ValueType())
-                {
+                // affine maps [A | b] between world frame and cell coordinates, see getWorldToCellMatrix()
+                AffineMatrix _world_to_cell;
+                AffineMatrix _cell_to_world;
+
+                void updateMatrices() {
+                    const ScalarType inv_cell_size = ScalarType(1) / _cell_size;
+                    _world_to_cell.template block<3, 3>(0, 0) = _inv_transform.linear() * inv_cell_size;
+                    _world_to_cell.col(3) = (_inv_transform.translation() - _min_point) * inv_cell_size;
+                    _cell_to_world.template block<3, 3>(0, 0) = _transform.linear() * _cell_size;
+                    _cell_to_world.col(3) = _transform.linear() * _min_point + _transform.translation();
+                }
+
+                static inline Vector3s applyAffine(const AffineMatrix& matrix, const Vector3s& point) {
+                    return matrix.template block<3, 3>(0, 0) * point + matrix.col(3);
+                }
+
+                // Number of points that are transformed at once by the batched kernels.
+                static constexpr long BATCH_BLOCK_SIZE = 256;
+
+                // Sets column i of out to matrix applied to column i of in, block by block, so that each block
+                // of input, output and intermediate results stays in cache.
+                static void applyAffine(const AffineMatrix& matrix, const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& in,
+                                        Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& out) {
+                    out.resize(3, in.cols());
+                    for (long begin = 0; begin < in.cols(); begin += BATCH_BLOCK_SIZE) {
+                        long block_size = in.cols() - begin < BATCH_BLOCK_SIZE ? in.cols() - begin : BATCH_BLOCK_SIZE;
+                        out.middleCols(begin, block_size).noalias() =
+                            matrix.template block<3, 3>(0, 0) * in.middleCols(begin, block_size);
+                        out.middleCols(begin, block_size).colwise() += matrix.col(3);
+                    }
+                }
+            public:
+                VoxelGridMapping(const Vector3s& min_point, const Vector3s& max_point, const ScalarType& cell_size) {
+                    reset(min_point, max_point, cell_size);
+                }
+
+                VoxelGridMapping(const VoxelGridMapping& other) = default;
+                ~VoxelGridMapping() = default;
+                VoxelGridMapping& operator=(const VoxelGridMapping& other) = default;
+
+                /*
+                 * Reset this mapping to the given bounding box and cell size. The transformation
+                 * is reset to identity.
+                 */
+                void reset(const Vector3s& min_point, const Vector3s& max_point, const ScalarType& cell_size) {
                     _cell_size = cell_size;
                     _min_point = min_point;
                     _max_point = max_point;
@@ -510,13 +853,189 @@ namespace sim_env {
                     _num_cells[2] = (size_t)std::max(std::ceil(dimensions[2] / cell_size), ScalarType(1.0));
                     _transform.setIdentity();
                     _inv_transform.setIdentity();
-                    this->reset(_num_cells[0], _num_cells[1], _num_cells[2], default_value);
+                    updateMatrices();
+                }
+
+                /*
+                 * Returns the number of cells along each axis.
+                 */
+                const std::array<size_t, 3>& getNumCells() const {
+                    return _num_cells;
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return idx.ix >= 0 and idx.iy >= 0 and idx.iz >= 0 and
+                        (size_t)idx.ix < _num_cells[0] and (size_t)idx.iy < _num_cells[1] and (size_t)idx.iz < _num_cells[2];
+                }
+
+                /*
+                 * Returns the index of the voxel in which the specified position in world frame lies.
+                 * Note that the returned index may be out of bounds, if the position is out of bounds.
+                 */
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    Vector3s coordinates = applyAffine(_world_to_cell, position);
+                    return SignedIndex(coordinates[0], coordinates[1], coordinates[2]);
+                }
+
+                /*
+                 * Returns the index of the voxel in which the specified position in world frame lies.
+                 * @param position - the query position
+                 * @param is_valid - flag that is set to true, if the returned index is valid, else false
+                 * @return - an index that is either value or undefined depending on is_valid flag
+                 */
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    SignedIndex idx = getCellIdx(position);
+                    is_valid = inBounds(idx);
+                    if (is_valid) {
+                        return idx.toUnsignedIndex();
+                    }
+                    return UnsignedIndex();
+                }
+
+                /*
+                 * Maps the given position to the local frame of the grid and computes the
+                 * voxel index for that position.
+                 * @param in_position - query position in world frame
+                 * @param out_pos - in_position transformed to local frame
+                 * @param idx - index of the voxel containing out_pos, if out_pos is within bounds
+                 * @return whether out_pos is within bounds
+                 */
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    out_pos = _inv_transform * in_position;
+                    SignedIndex sidx = getCellIdx(in_position);
+                    bool is_valid = inBounds(sidx);
+                    if (is_valid) {
+                        idx = sidx.toUnsignedIndex();
+                        return true;
+                    }
+                    return false;
+                }
+
+                /*
+                 * Returns the position in R^3 of the center or min corner of the voxel with index idx
+                 * @param idx - a valid cell index
+                 * @param position - output position of either the center or min corner position of the voxel
+                 * @param b_center - if true, position is the position of the center, else of min corner
+                 */
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    const ScalarType offset = b_center ? ScalarType(0.5) : ScalarType(0);
+                    position = applyAffine(_cell_to_world, Vector3s(idx.ix + offset, idx.iy + offset, idx.iz + offset));
+                }
+
+                /*
+                 * Batched version of getCellPosition.
+                 * @param indices - valid cell indices
+                 * @param positions - output, column i is set to the position of the center or min corner of indices[i]
+                 * @param b_center - if true, positions are the positions of the centers, else of the min corners
+                 */
+                void getCellPositions(const std::vector<UnsignedIndex>& indices,
+                                      Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions, bool b_center) const {
+                    const ScalarType offset = b_center ? ScalarType(0.5) : ScalarType(0);
+                    Eigen::Matrix<ScalarType, 3, Eigen::Dynamic> coordinates(3, indices.size());
+                    for (size_t i = 0; i < indices.size(); ++i) {
+                        coordinates.col(i) << indices[i].ix + offset, indices[i].iy + offset, indices[i].iz + offset;
+                    }
+                    applyAffine(_cell_to_world, coordinates, positions);
+                }
+
+                /*
+                 * Returns the continuous cell coordinates of the given position in world frame, i.e. the
+                 * position in the local frame relative to the min corner of the grid in units of cells.
+                 * The voxel with index (ix, iy, iz) spans the coordinates [ix, ix + 1) x [iy, iy + 1) x [iz, iz + 1).
+                 */
+                Vector3s getCellCoordinates(const Vector3s& position) const {
+                    return applyAffine(_world_to_cell, position);
+                }
+
+                /*
+                 * Returns the affine map from positions in world frame to cell coordinates as a 3x4 matrix [A | b],
+                 * i.e. cell coordinates = A * position + b. The scaling by the cell size is folded into A,
+                 * so that applying this map requires no divisions. The matrix is precomputed whenever the
+                 * transform or bounding box changes and is shared by getCellIdx, mapToGrid and getCellCoordinates.
+                 */
+                const AffineMatrix& getWorldToCellMatrix() const {
+                    return _world_to_cell;
+                }
+
+                /*
+                 * Returns the affine map from cell coordinates to positions in world frame as a 3x4 matrix [A | b],
+                 * i.e. the inverse of getWorldToCellMatrix(). It is used by getCellPosition.
+                 */
+                const AffineMatrix& getCellToWorldMatrix() const {
+                    return _cell_to_world;
+                }
+
+                /*
+                 * Batched version of getCellCoordinates. Column i of coordinates is set to the cell coordinates
+                 * of column i of positions.
+                 */
+                void getCellCoordinates(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                                        Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& coordinates) const {
+                    applyAffine(_world_to_cell, positions, coordinates);
+                }
+
+                ScalarType getCellSize() const {
+                    return _cell_size;
+                }
+
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    min_point = _min_point;
+                    max_point = _max_point;
+                }
+
+                /*
+                 * Sets the transformation from the local frame of the grid to world frame. The given transformation
+                 * is expected to only consist of a rotation and translation, so that its inverse is [R^T | -R^T t].
+                 */
+                void setTransform(const Transform& tf) {
+                    _transform = tf;
+                    _inv_transform.setIdentity();
+                    _inv_transform.linear() = tf.linear().transpose();
+                    _inv_transform.translation() = -(_inv_transform.linear() * tf.translation());
+                    updateMatrices();
+                }
+
+                Transform getTransform() const {
+                    return _transform;
+                }
+
+                Transform getInvTransform() const {
+                    return _inv_transform;
+                }
+        };
+
+        /**
+         * A VoxelGrid extends the functionality of Grid3D by spatial relations. Each
+         * cell of the grid represents a volume in R^3. The size of the volume is determined
+         * by the size of the voxel (which is identical in each dimension). Furthermore,
+         * a voxel grid provides a transformation from some world frame to its local frame.
+         * The memory layout of the cells is defined by the Layout policy (see Grid3D).
+         */
+        template<typename ScalarType, typename ValueType, typename Layout = RowMajorLayout>
+        class VoxelGrid : public grid::Grid3D<ValueType, Layout> {
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW;
+            public:
+                template<typename ScalarType1, typename ValueType1, typename Layout1>
+                friend std::ostream& operator<<(std::ostream& os, VoxelGrid<ScalarType1, ValueType1, Layout1> const& grid);
+                template<typename ScalarType1, typename ValueType1, typename Layout1>
+                friend std::istream& operator>>(std::istream& is, VoxelGrid<ScalarType1, ValueType1, Layout1>& grid);
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+            private:
+                VoxelGridMapping<ScalarType> _mapping;
+            protected:
+                void resetVoxelGrid(const Vector3s& min_point, const Vector3s& max_point,
+                            const ScalarType& cell_size, ValueType default_value=ValueType())
+                {
+                    _mapping.reset(min_point, max_point, cell_size);
+                    auto& num_cells = _mapping.getNumCells();
+                    this->reset(num_cells[0], num_cells[1], num_cells[2], default_value);
                 }
 
             public:
                 VoxelGrid(const Vector3s& min_point, const Vector3s& max_point,
                             const ScalarType& cell_size, ValueType default_value=ValueType()) :
-                    Grid3D<ValueType>(1, 1, 1, default_value)
+                    Grid3D<ValueType, Layout>(1, 1, 1, default_value),
+                    _mapping(min_point, max_point, cell_size)
                 {
                     resetVoxelGrid(min_point, max_point, cell_size, default_value);
                 }
@@ -531,10 +1050,7 @@ namespace sim_env {
                 * You can check this by calling inBounds(idx). Alternatively, use getValidCellIdx(..)
                 */
                 SignedIndex getCellIdx(const Vector3s& position) const {
-                    auto local_pos = _inv_transform * position;
-                    local_pos -= _min_point;
-                    SignedIndex idx(local_pos[0] / _cell_size, local_pos[1] / _cell_size, local_pos[2] / _cell_size);
-                    return idx;
+                    return _mapping.getCellIdx(position);
                 }
 
                 /*
@@ -544,12 +1060,7 @@ namespace sim_env {
                 * @return - an index that is either value or undefined depending on is_valid flag
                 */
                 UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
-                    SignedIndex idx = getCellIdx(position);
-                    is_valid = this->inBounds(idx);
-                    if (is_valid) {
-                        return idx.toUnsignedIndex();
-                    }
-                    return UnsignedIndex();
+                    return _mapping.getValidCellIdx(position, is_valid);
                 }
 
                 /*
@@ -561,16 +1072,7 @@ namespace sim_env {
                 * @return whether out_pos is within bounds
                 */
                 bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
-                    auto local_pos = _inv_transform * in_position;
-                    out_pos = local_pos;
-                    local_pos -= _min_point;
-                    SignedIndex sidx(local_pos[0] / _cell_size, local_pos[1] / _cell_size, local_pos[2] / _cell_size);
-                    bool is_valid = this->inBounds(sidx);
-                    if (is_valid) {
-                        idx = sidx.toUnsignedIndex();
-                        return true;
-                    }
-                    return false;
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
                 }
 
                 /*
@@ -580,16 +1082,19 @@ namespace sim_env {
                 * @param b_center - if true, position is the position of the center, else of min corner
                 */
                 void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
-                    position[0] = idx.ix * _cell_size;
-                    position[1] = idx.iy * _cell_size;
-                    position[2] = idx.iz * _cell_size;
-                    position += _min_point;
-                    if (b_center) position += Vector3s(_cell_size / 2.0, _cell_size / 2.0, _cell_size / 2.0);
-                    position = _transform * position;
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                /*
+                 * Batched version of getCellPosition, see VoxelGridMapping::getCellPositions.
+                 */
+                void getCellPositions(const std::vector<UnsignedIndex>& indices,
+                                      Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions, bool b_center) const {
+                    _mapping.getCellPositions(indices, positions, b_center);
                 }
 
                 ScalarType getCellSize() const {
-                    return _cell_size;
+                    return _mapping.getCellSize();
                 }
 
                 /**
@@ -597,8 +1102,7 @@ namespace sim_env {
                  * This is essentially the bounding box passed to the constructor.
                  */
                 void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
-                    min_point = _min_point;
-                    max_point = _max_point;
+                    _mapping.getBoundingBox(min_point, max_point);
                 }
 
                 /**
@@ -606,27 +1110,207 @@ namespace sim_env {
                  * to only consist of a rotation and translation.
                  */
                 void setTransform(const Eigen::Transform<ScalarType, 3, Eigen::Affine>& tf) {
-                    _transform = tf;
-                    _inv_transform = _transform.inverse();
-                    // TODO there is an easy way to compute this inverse, but Eigen makes this unnecessary difficult.
-                    // _inv_transform.matrix().block(0, 0, 3, 3) = tf.matrix().transpose().block(0, 0, 3, 3);
-                    // Vector3s translation(tf.translation.x(), tf.translation.y(), tf.translation.z());
-                    // auto translation = _inv_transform.matrix().block(0, 0, 3, 3) * tf.translation()
-                    // _inv_transform.matrix().block(0, 3, 3, 1) = translation;
+                    _mapping.setTransform(tf);
                 }
 
                 Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
-                    return _transform;
+                    return _mapping.getTransform();
                 }
 
                 Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
-                    return _inv_transform;
+                    return _mapping.getInvTransform();
+                }
+
+                /**
+                 * Returns the spatial mapping of this grid.
+                 */
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+
+                /*
+                 * Batched version of getValidCellIdx that computes flat indices (see Grid3D::getFlatIndex).
+                 * The world positions are mapped to cell coordinates by multiplying with the precomputed
+                 * matrix of the mapping (see VoxelGridMapping::getWorldToCellMatrix), i.e. without any division.
+                 * @param positions - query positions in world frame, one per column
+                 * @param flat_indices - output, flat index of the cell containing positions.col(i),
+                 *                       undefined if the position is out of bounds
+                 * @param valid - output, valid[i] is true iff positions.col(i) is within bounds. Note that, unlike
+                 *                getValidCellIdx, which truncates towards zero, positions less than a cell below
+                 *                the lower bounds and non-finite positions are reported as out of bounds.
+                 */
+                void getFlatCellIndices(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                                        std::vector<size_t>& flat_indices,
+                                        Eigen::Array<bool, Eigen::Dynamic, 1>& valid) const {
+                    flat_indices.resize(positions.cols());
+                    valid.resize(positions.cols());
+                    computeFlatCellIndices(positions, 0, positions.cols(), flat_indices, valid);
+                }
+
+                /*
+                 * Same as getFlatCellIndices, but distributes the positions over multiple threads.
+                 * @param num_threads - maximal number of threads to use, 0 for all available
+                 */
+                void getFlatCellIndicesParallel(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                                                std::vector<size_t>& flat_indices,
+                                                Eigen::Array<bool, Eigen::Dynamic, 1>& valid,
+                                                unsigned int num_threads = 0) const {
+                    flat_indices.resize(positions.cols());
+                    valid.resize(positions.cols());
+                    utils::parallel::parallelFor(0, positions.cols(), [&](size_t begin, size_t end) {
+                        computeFlatCellIndices(positions, begin, end, flat_indices, valid);
+                    }, num_threads, BATCH_BLOCK_SIZE);
+                }
+
+                /*
+                 * Returns the trilinear interpolation of the cell values at the given position in world frame.
+                 * Values are assumed to be located at cell centers. Outside of the convex hull of the cell centers
+                 * the value of the closest point within it is returned. Requires ValueType to support
+                 * addition and multiplication with ScalarType.
+                 */
+                ValueType interpolate(const Vector3s& position) const {
+                    InterpolationCell cell;
+                    getInterpolationCell(_mapping.getCellCoordinates(position), cell);
+                    return interpolateCell(cell);
+                }
+
+                /*
+                 * Returns the gradient in world frame of the trilinear interpolation at the given position.
+                 * Along axes on which the position is outside of the convex hull of the cell centers,
+                 * the interpolation is constant, i.e. the gradient in local frame is zero along these axes.
+                 * Requires ValueType to be convertible to ScalarType.
+                 */
+                Vector3s gradient(const Vector3s& position) const {
+                    InterpolationCell cell;
+                    getInterpolationCell(_mapping.getCellCoordinates(position), cell);
+                    return _mapping.getTransform().linear() * localGradient(cell);
+                }
+
+                /*
+                 * Batched version of interpolate for grids with scalar values.
+                 * @param positions - query positions in world frame, one per column
+                 * @param values - output, values[i] is the interpolated value at positions.col(i)
+                 */
+                void interpolate(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                                 Eigen::Matrix<ScalarType, Eigen::Dynamic, 1>& values) const {
+                    Eigen::Matrix<ScalarType, 3, Eigen::Dynamic> coordinates;
+                    _mapping.getCellCoordinates(positions, coordinates);
+                    values.resize(positions.cols());
+                    InterpolationCell cell;
+                    for (long i = 0; i < positions.cols(); ++i) {
+                        getInterpolationCell(coordinates.col(i), cell);
+                        values[i] = interpolateCell(cell);
+                    }
+                }
+
+                /*
+                 * Batched version of gradient for grids with scalar values.
+                 * @param positions - query positions in world frame, one per column
+                 * @param gradients - output, gradients.col(i) is the gradient in world frame at positions.col(i)
+                 */
+                void gradient(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                              Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& gradients) const {
+                    Eigen::Matrix<ScalarType, 3, Eigen::Dynamic> coordinates;
+                    _mapping.getCellCoordinates(positions, coordinates);
+                    gradients.resize(3, positions.cols());
+                    InterpolationCell cell;
+                    for (long i = 0; i < positions.cols(); ++i) {
+                        getInterpolationCell(coordinates.col(i), cell);
+                        gradients.col(i) = localGradient(cell);
+                    }
+                    gradients = _mapping.getTransform().linear() * gradients;
+                }
+
+            private:
+                // number of positions that are transformed at once in batched queries
+                static constexpr long BATCH_BLOCK_SIZE = 256;
+
+                void computeFlatCellIndices(const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& positions,
+                                            long begin, long end, std::vector<size_t>& flat_indices,
+                                            Eigen::Array<bool, Eigen::Dynamic, 1>& valid) const {
+                    const Eigen::Matrix<ScalarType, 3, 4> matrix = _mapping.getWorldToCellMatrix();
+                    const size_t x_size = this->getXSize(), y_size = this->getYSize(), z_size = this->getZSize();
+                    Eigen::Matrix<ScalarType, 3, Eigen::Dynamic, Eigen::ColMajor, 3, BATCH_BLOCK_SIZE> coordinates;
+                    for (long block_begin = begin; block_begin < end; block_begin += BATCH_BLOCK_SIZE) {
+                        long block_size = end - block_begin < BATCH_BLOCK_SIZE ? end - block_begin : BATCH_BLOCK_SIZE;
+                        coordinates.noalias() = matrix.template block<3, 3>(0, 0) * positions.middleCols(block_begin, block_size);
+                        coordinates.colwise() += matrix.col(3);
+                        for (long i = 0; i < block_size; ++i) {
+                            // check the bounds before converting to integers, which also rejects NaNs and
+                            // coordinates in (-1, 0); within bounds truncation is the same as std::floor
+                            const ScalarType cx = coordinates(0, i), cy = coordinates(1, i), cz = coordinates(2, i);
+                            bool is_valid = cx >= ScalarType(0) and cx < ScalarType(x_size) and
+                                cy >= ScalarType(0) and cy < ScalarType(y_size) and
+                                cz >= ScalarType(0) and cz < ScalarType(z_size);
+                            valid[block_begin + i] = is_valid;
+                            flat_indices[block_begin + i] = is_valid ?
+                                this->getFlatIndex((size_t)cx, (size_t)cy, (size_t)cz) : 0;
+                        }
+                    }
+                }
+
+                // The eight cells surrounding a query position and the interpolation weights along each axis
+                struct InterpolationCell {
+                    size_t lower[3];
+                    size_t upper[3];
+                    ScalarType t[3];
+                    bool inside[3];
+                };
+
+                inline void getInterpolationCell(const Vector3s& cell_coords, InterpolationCell& cell) const {
+                    const size_t sizes[3] = {this->getXSize(), this->getYSize(), this->getZSize()};
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        // cell centers are at integer coordinates + 0.5
+                        ScalarType u = cell_coords[d] - ScalarType(0.5);
+                        ScalarType max_u = ScalarType(sizes[d] - 1);
+                        cell.inside[d] = u >= ScalarType(0) and u <= max_u and sizes[d] > 1;
+                        u = std::min(std::max(u, ScalarType(0)), max_u);
+                        size_t lower = std::min((size_t)u, sizes[d] > 1 ? sizes[d] - 2 : size_t(0));
+                        cell.lower[d] = lower;
+                        cell.upper[d] = std::min(lower + 1, sizes[d] - 1);
+                        cell.t[d] = u - ScalarType(lower);
+                    }
+                }
+
+                inline ValueType interpolateCell(const InterpolationCell& cell) const {
+                    const ScalarType tx = cell.t[0], ty = cell.t[1], tz = cell.t[2];
+                    const size_t x0 = cell.lower[0], y0 = cell.lower[1], z0 = cell.lower[2];
+                    const size_t x1 = cell.upper[0], y1 = cell.upper[1], z1 = cell.upper[2];
+                    ValueType c00 = (*this)(x0, y0, z0) * (1 - tx) + (*this)(x1, y0, z0) * tx;
+                    ValueType c10 = (*this)(x0, y1, z0) * (1 - tx) + (*this)(x1, y1, z0) * tx;
+                    ValueType c01 = (*this)(x0, y0, z1) * (1 - tx) + (*this)(x1, y0, z1) * tx;
+                    ValueType c11 = (*this)(x0, y1, z1) * (1 - tx) + (*this)(x1, y1, z1) * tx;
+                    ValueType c0 = c00 * (1 - ty) + c10 * ty;
+                    ValueType c1 = c01 * (1 - ty) + c11 * ty;
+                    return c0 * (1 - tz) + c1 * tz;
+                }
+
+                // gradient in local frame
+                inline Vector3s localGradient(const InterpolationCell& cell) const {
+                    const ScalarType tx = cell.t[0], ty = cell.t[1], tz = cell.t[2];
+                    const size_t x0 = cell.lower[0], y0 = cell.lower[1], z0 = cell.lower[2];
+                    const size_t x1 = cell.upper[0], y1 = cell.upper[1], z1 = cell.upper[2];
+                    const ScalarType c000 = (*this)(x0, y0, z0), c100 = (*this)(x1, y0, z0);
+                    const ScalarType c010 = (*this)(x0, y1, z0), c110 = (*this)(x1, y1, z0);
+                    const ScalarType c001 = (*this)(x0, y0, z1), c101 = (*this)(x1, y0, z1);
+                    const ScalarType c011 = (*this)(x0, y1, z1), c111 = (*this)(x1, y1, z1);
+                    Vector3s grad;
+                    grad[0] = ((c100 - c000) * (1 - ty) + (c110 - c010) * ty) * (1 - tz)
+                              + ((c101 - c001) * (1 - ty) + (c111 - c011) * ty) * tz;
+                    grad[1] = ((c010 - c000) * (1 - tx) + (c110 - c100) * tx) * (1 - tz)
+                              + ((c011 - c001) * (1 - tx) + (c111 - c101) * tx) * tz;
+                    grad[2] = ((c001 - c000) * (1 - tx) + (c101 - c100) * tx) * (1 - ty)
+                              + ((c011 - c010) * (1 - tx) + (c111 - c110) * tx) * ty;
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (not cell.inside[d]) grad[d] = ScalarType(0);
+                    }
+                    return grad / _mapping.getCellSize();
                 }
         };
 
         // Operator for convenient output of VoxelGrids; needs ScalarType and ValueType to be streamable
-        template <typename ScalarType, typename ValueType>
-        inline std::ostream& operator<<(std::ostream& os, sim_env::grid::VoxelGrid<ScalarType, ValueType> const& grid) {
+        template <typename ScalarType, typename ValueType, typename Layout>
+        inline std::ostream& operator<<(std::ostream& os, sim_env::grid::VoxelGrid<ScalarType, ValueType, Layout> const& grid) {
             Eigen::Matrix<ScalarType, 3, 1> min_pos;
             Eigen::Matrix<ScalarType, 3, 1> max_pos;
             grid.getBoundingBox(min_pos, max_pos);
@@ -640,8 +1324,8 @@ namespace sim_env {
         }
 
         // Operator for convenient input of VoxelGrids; needs ScalarType and ValueType to be streamable
-        template <typename ScalarType, typename ValueType>
-        inline std::istream& operator>>(std::istream& is, sim_env::grid::VoxelGrid<ScalarType, ValueType>& grid) {
+        template <typename ScalarType, typename ValueType, typename Layout>
+        inline std::istream& operator>>(std::istream& is, sim_env::grid::VoxelGrid<ScalarType, ValueType, Layout>& grid) {
             Eigen::Matrix<ScalarType, 3, 1> min_pos;
             Eigen::Matrix<ScalarType, 3, 1> max_pos;
             is >> min_pos[0] >> min_pos[1] >> min_pos[2];
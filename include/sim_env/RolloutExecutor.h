@@ -0,0 +1,129 @@
+//
+// Parallel execution of rollouts on pooled worlds.
+//
+
+#ifndef SIM_ENV_ROLLOUT_EXECUTOR_H
+#define SIM_ENV_ROLLOUT_EXECUTOR_H
+
+#include <Eigen/Dense>
+#include <functional>
+#include <memory>
+#include <sim_env/Controller.h>
+#include <sim_env/SimEnv.h>
+#include <sim_env/WorldPool.h>
+#include <string>
+#include <vector>
+
+namespace sim_env {
+class RolloutExecutor;
+typedef std::shared_ptr<RolloutExecutor> RolloutExecutorPtr;
+typedef std::shared_ptr<const RolloutExecutor> RolloutExecutorConstPtr;
+
+/**
+     * A single action of a rollout: an input that is applied to the robot for num_steps physics steps.
+     */
+struct RolloutAction {
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    // controller target or raw control output, see RolloutExecutor::InputMode
+    Eigen::VectorXf input;
+    unsigned int num_steps;
+    RolloutAction()
+        : num_steps(1)
+    {
+    }
+    RolloutAction(const Eigen::VectorXf& linput, unsigned int lnum_steps)
+        : input(linput)
+        , num_steps(lnum_steps)
+    {
+    }
+};
+typedef std::vector<RolloutAction> ActionSequence;
+
+struct RolloutResult {
+    // state of the world after the last action
+    WorldState final_state;
+    // all contacts that occurred during the rollout
+    std::vector<Contact> contacts;
+    // cost as computed by the cost function, 0 if there is none
+    float cost;
+    RolloutResult()
+        : cost(0.0f)
+    {
+    }
+};
+
+/**
+     * A RolloutExecutor evaluates many action sequences for a robot by simulating each of them with
+     * World::stepPhysics on a world of a WorldPool. Each rollout starts from the master state of the pool.
+     * The rollouts are distributed dynamically over multiple threads: each thread leases one world and
+     * repeatedly takes the next pending rollout, so that rollouts of different lengths are balanced.
+     * The controller installed on the robot for a rollout is removed when the rollout ends.
+     */
+class RolloutExecutor {
+public:
+    enum class InputMode {
+        // the input of an action is the target of a RobotController created by the controller factory
+        Target,
+        // the input of an action is the control output applied to the robot in every physics step
+        Raw
+    };
+    /**
+         * Creates the controller for the robot of a pooled world. Called once per rollout.
+         */
+    typedef std::function<RobotControllerPtr(RobotPtr robot)> ControllerFactory;
+    /**
+         * Computes the cost of a rollout. Called in the worker thread with the world in its final state.
+         */
+    typedef std::function<float(WorldPtr world, const ActionSequence& actions, const RolloutResult& result)>
+        CostFunction;
+
+    /**
+         * @param pool - pool of worlds to simulate in. At most pool->getNumWorlds() rollouts are run concurrently.
+         * @param robot_name - name of the robot to control
+         * @param mode - how the inputs of actions are interpreted
+         * @param controller_factory - required if mode is InputMode::Target
+         */
+    RolloutExecutor(WorldPoolPtr pool, const std::string& robot_name, InputMode mode,
+        ControllerFactory controller_factory = nullptr);
+    ~RolloutExecutor();
+
+    void setCostFunction(CostFunction cost_fn);
+    /**
+         * Sets whether contacts are recorded. Recording contacts is enabled by default.
+         */
+    void setRecordContacts(bool b_record);
+    WorldPoolPtr getPool() const;
+
+    /**
+         * Executes all given action sequences.
+         * @param sequences - the action sequences to execute
+         * @param results - results[i] is filled with the result of sequences[i]. Existing entries are reused.
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         * Throws a std::runtime_error if a pooled world can not be reset to the master state.
+         */
+    void execute(const std::vector<ActionSequence>& sequences, std::vector<RolloutResult>& results,
+        unsigned int num_threads = 0);
+    /**
+         * Executes a single action sequence on the calling thread.
+         */
+    void execute(const ActionSequence& sequence, RolloutResult& result);
+
+    /**
+         * Returns the throughput of the last call of execute(sequences, ..) in rollouts per second.
+         */
+    float getLastRolloutsPerSecond() const;
+
+private:
+    WorldPoolPtr _pool;
+    std::string _robot_name;
+    InputMode _mode;
+    ControllerFactory _controller_factory;
+    CostFunction _cost_fn;
+    bool _record_contacts;
+    float _last_rollouts_per_second;
+
+    void runRollout(WorldPtr world, const ActionSequence& sequence, RolloutResult& result);
+};
+}
+
+#endif //SIM_ENV_ROLLOUT_EXECUTOR_H
@@ -0,0 +1,129 @@
+//
+// Pool of pre-cloned worlds.
+//
+
+#ifndef SIM_ENV_WORLD_POOL_H
+#define SIM_ENV_WORLD_POOL_H
+
+#include <condition_variable>
+#include <memory>
+#include <mutex>
+#include <sim_env/SimEnv.h>
+#include <vector>
+
+namespace sim_env {
+class WorldPool;
+typedef std::shared_ptr<WorldPool> WorldPoolPtr;
+typedef std::shared_ptr<const WorldPool> WorldPoolConstPtr;
+
+/**
+     * A WorldPool keeps a set of clones of a master world and hands them out to workers, e.g. to rollout
+     * or planning threads. Cloning a world is expensive, hence the clones are created once and reused:
+     * when a world is acquired, it is resynchronized to the master state using World::setWorldState.
+     * The master state is a snapshot of the master world's state and only changes when updateMasterState
+     * or setMasterState is called. Note that resynchronization only restores the state of the objects
+     * of the master state, i.e. a borrower must not add or remove objects. Likewise, robot controllers are
+     * not part of the state, hence a borrower must remove any controller it installs before releasing a world.
+     * All functions are thread-safe.
+     */
+class WorldPool {
+public:
+    /**
+         * RAII handle of an acquired world. The world is released when the handle is destroyed.
+         */
+    class Lease {
+    public:
+        Lease();
+        Lease(Lease&& other);
+        Lease& operator=(Lease&& other);
+        Lease(const Lease& other) = delete;
+        Lease& operator=(const Lease& other) = delete;
+        ~Lease();
+
+        WorldPtr getWorld() const;
+        World* operator->() const;
+        explicit operator bool() const;
+        /**
+             * Returns the world to the pool. Afterwards this lease is empty.
+             */
+        void release();
+
+    private:
+        friend class WorldPool;
+        Lease(WorldPool* pool, WorldPtr world);
+        WorldPool* _pool;
+        WorldPtr _world;
+    };
+
+    /**
+         * Creates a new pool.
+         * @param master - the world to clone
+         * @param num_worlds - number of clones to create upfront
+         */
+    WorldPool(WorldPtr master, unsigned int num_worlds);
+    ~WorldPool();
+    WorldPool(const WorldPool& other) = delete;
+    WorldPool& operator=(const WorldPool& other) = delete;
+
+    /**
+         * Returns an available world synchronized to the master state. Blocks until a world is available.
+         * The world must be returned with release(..).
+         * Throws a std::runtime_error if the world can not be synchronized. In this case the world stays in the pool.
+         */
+    WorldPtr acquire();
+    /**
+         * Same as acquire, but returns nullptr instead of blocking if no world is available.
+         */
+    WorldPtr tryAcquire();
+    /**
+         * Same as acquire, but returns a lease that releases the world automatically.
+         */
+    Lease lease();
+    /**
+         * Returns an acquired world to the pool.
+         * Throws a std::invalid_argument if world was not acquired from this pool.
+         */
+    void release(WorldPtr world);
+
+    /**
+         * Creates additional clones, so that the pool contains at least num_worlds worlds.
+         */
+    void reserve(unsigned int num_worlds);
+    /**
+         * Sets the master state to the current state of the master world.
+         */
+    void updateMasterState();
+    /**
+         * Sets the master state that acquired worlds are synchronized to.
+         */
+    void setMasterState(const WorldState& state);
+    WorldState getMasterState() const;
+    WorldPtr getMasterWorld() const;
+
+    unsigned int getNumWorlds() const;
+    unsigned int getNumAvailable() const;
+
+private:
+    struct PooledWorld {
+        WorldPtr world;
+        bool available;
+        // copy of the master state to synchronize with, updated when the master state changes
+        WorldState sync_state;
+        size_t sync_version;
+    };
+    typedef std::shared_ptr<PooledWorld> PooledWorldPtr;
+
+    WorldPtr _master;
+    std::shared_ptr<const WorldState> _master_state;
+    // incremented whenever the master state changes
+    size_t _master_version;
+    std::vector<PooledWorldPtr> _worlds;
+    mutable std::mutex _mutex;
+    std::condition_variable _available_condition;
+
+    WorldPtr checkout(std::unique_lock<std::mutex>& lock);
+    PooledWorldPtr createWorld();
+};
+}
+
+#endif //SIM_ENV_WORLD_POOL_H
@@ -0,0 +1,224 @@
+//
+// Flat, contiguous representation of world states.
+//
+
+#ifndef SIM_ENV_WORLD_STATE_BUFFER_H
+#define SIM_ENV_WORLD_STATE_BUFFER_H
+
+#include <Eigen/Dense>
+#include <Eigen/Geometry>
+#include <Eigen/StdVector>
+#include <memory>
+#include <sim_env/SimEnv.h>
+#include <string>
+#include <vector>
+
+namespace sim_env {
+class WorldStateLayout;
+typedef std::shared_ptr<WorldStateLayout> WorldStateLayoutPtr;
+typedef std::shared_ptr<const WorldStateLayout> WorldStateLayoutConstPtr;
+
+class WorldStateBuffer;
+
+class WorldStateAccessor;
+typedef std::shared_ptr<WorldStateAccessor> WorldStateAccessorPtr;
+typedef std::shared_ptr<const WorldStateAccessor> WorldStateAccessorConstPtr;
+
+/**
+     * A WorldStateLayout is a precomputed schema that maps the state of a world to a flat float array.
+     * The objects are ordered by name, i.e. in the same order as in a WorldState. For each object the
+     * array contains the block
+     *      [x, y, z, qx, qy, qz, qw, dof_positions (num_dofs), dof_velocities (num_dofs)]
+     * where (x, y, z) is the translation of the object's pose and q its rotation as unit quaternion
+     * with qw >= 0. The active DOFs of each object are stored in the layout, not in the array.
+     * A layout is immutable and can be shared by all worlds with the same objects, e.g. clones.
+     */
+class WorldStateLayout {
+public:
+    // number of floats for the pose of an object
+    static const unsigned int POSE_SIZE = 7;
+
+    struct ObjectEntry {
+        std::string name;
+        // offset of this object's block within the array
+        size_t offset;
+        unsigned int num_dofs;
+        Eigen::VectorXi active_dofs;
+
+        size_t getPositionsOffset() const { return offset + POSE_SIZE; }
+        size_t getVelocitiesOffset() const { return offset + POSE_SIZE + num_dofs; }
+        size_t getSize() const { return POSE_SIZE + 2 * num_dofs; }
+    };
+
+    /**
+         * Creates an empty layout.
+         */
+    WorldStateLayout();
+    /**
+         * Creates the layout for the objects and DOFs of the given state.
+         */
+    explicit WorldStateLayout(const WorldState& state);
+    /**
+         * Creates the layout for the current objects (including robots) of the given world.
+         */
+    explicit WorldStateLayout(WorldConstPtr world);
+    ~WorldStateLayout();
+
+    /**
+         * Returns the number of floats of a buffer with this layout.
+         */
+    size_t getSize() const;
+    size_t getNumObjects() const;
+    const ObjectEntry& getObjectEntry(size_t object_idx) const;
+    const std::vector<ObjectEntry>& getObjectEntries() const;
+    /**
+         * Returns the index of the object with the given name, or -1 if there is no such object.
+         */
+    int getObjectIndex(const std::string& name) const;
+    /**
+         * Returns whether the given state has exactly the objects and numbers of DOFs of this layout.
+         */
+    bool isCompatible(const WorldState& state) const;
+    /**
+         * Returns whether buffers with the other layout have the same memory layout as buffers with this layout,
+         * i.e. both layouts have the same objects with the same numbers of DOFs at the same offsets.
+         */
+    bool isCompatible(const WorldStateLayout& other) const;
+
+private:
+    std::vector<ObjectEntry> _entries;
+    size_t _size;
+
+    void computeOffsets();
+};
+
+/**
+     * A WorldStateBuffer stores a world state as one contiguous float array laid out by a WorldStateLayout.
+     * Once a buffer has its layout, none of its getters and setters allocate memory, as long as
+     * caller-provided outputs (ObjectState, WorldState) have been used with the same layout before.
+     * This makes buffers suitable for snapshotting states in tight loops, e.g. in sampling-based planners.
+     */
+class WorldStateBuffer {
+public:
+    EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+    WorldStateBuffer();
+    explicit WorldStateBuffer(WorldStateLayoutConstPtr layout);
+    ~WorldStateBuffer();
+
+    /**
+         * Sets the layout of this buffer. The values are only reallocated if the size changes.
+         * The values are undefined afterwards.
+         */
+    void setLayout(WorldStateLayoutConstPtr layout);
+    WorldStateLayoutConstPtr getLayout() const;
+
+    size_t size() const;
+    float* data();
+    const float* data() const;
+    Eigen::VectorXf& getValues();
+    const Eigen::VectorXf& getValues() const;
+
+    /**
+         * Views into the block of the object with index object_idx (see WorldStateLayout::getObjectIndex).
+         */
+    Eigen::Map<Eigen::Vector3f> getPosition(size_t object_idx);
+    Eigen::Map<const Eigen::Vector3f> getPosition(size_t object_idx) const;
+    Eigen::Map<Eigen::Quaternionf> getOrientation(size_t object_idx);
+    Eigen::Map<const Eigen::Quaternionf> getOrientation(size_t object_idx) const;
+    Eigen::Map<Eigen::VectorXf> getDOFPositions(size_t object_idx);
+    Eigen::Map<const Eigen::VectorXf> getDOFPositions(size_t object_idx) const;
+    Eigen::Map<Eigen::VectorXf> getDOFVelocities(size_t object_idx);
+    Eigen::Map<const Eigen::VectorXf> getDOFVelocities(size_t object_idx) const;
+    /**
+         * Returns a view of the whole block of the given object.
+         */
+    Eigen::Map<Eigen::VectorXf> getObjectBlock(size_t object_idx);
+    Eigen::Map<const Eigen::VectorXf> getObjectBlock(size_t object_idx) const;
+
+    void getPose(size_t object_idx, Eigen::Affine3f& pose) const;
+    void setPose(size_t object_idx, const Eigen::Affine3f& pose);
+
+    /**
+         * Copies the state of the given object into object_state. The vectors of object_state
+         * are only resized if their sizes differ.
+         */
+    void getObjectState(size_t object_idx, ObjectState& object_state) const;
+    /**
+         * Copies object_state into the block of the given object.
+         * Throws a std::invalid_argument if the number of DOFs differs.
+         */
+    void setObjectState(size_t object_idx, const ObjectState& object_state);
+
+    /**
+         * Copies this buffer into state. If state already contains exactly the objects of the layout,
+         * its entries are reused, otherwise state is cleared and refilled.
+         */
+    void getWorldState(WorldState& state) const;
+    /**
+         * Copies state into this buffer. Throws a std::invalid_argument if state is not compatible
+         * with the layout of this buffer.
+         */
+    void setWorldState(const WorldState& state);
+
+private:
+    WorldStateLayoutConstPtr _layout;
+    Eigen::VectorXf _values;
+
+    const WorldStateLayout::ObjectEntry& getEntry(size_t object_idx) const;
+};
+
+/**
+     * A WorldStateAccessor binds a WorldStateLayout to the objects of a particular world, so that
+     * the state of the world can be read into and written from WorldStateBuffers without building
+     * a WorldState, i.e. without any map lookups or string comparisons.
+     * Apart from whatever Object::getState, Object::setState and Object::getActiveDOFs do internally,
+     * reading and writing states does not allocate memory.
+     * An accessor keeps the world alive. It must be recreated if objects are added to or removed from the world.
+     * An accessor is not thread-safe, use one accessor per world and thread.
+     */
+class WorldStateAccessor {
+public:
+    /**
+         * @param world - the world to access
+         * @param layout - layout of the buffers, if nullptr a layout is created from the world.
+         *          Throws a std::invalid_argument if the world lacks any object of the layout
+         *          or the number of DOFs of an object differs.
+         */
+    explicit WorldStateAccessor(WorldPtr world, WorldStateLayoutConstPtr layout = nullptr);
+    ~WorldStateAccessor();
+
+    WorldPtr getWorld() const;
+    WorldStateLayoutConstPtr getLayout() const;
+    ObjectPtr getObject(size_t object_idx) const;
+
+    /**
+         * Reads the current state of the world into buffer. The buffer is set to the layout of this accessor.
+         */
+    void readState(WorldStateBuffer& buffer);
+    /**
+         * Sets the state of the world to the state stored in buffer. The layout of the buffer must be the layout
+         * of this accessor or compatible with it (see WorldStateLayout::isCompatible), otherwise a
+         * std::invalid_argument is thrown. The active DOFs of the objects are left unchanged.
+         */
+    void writeState(const WorldStateBuffer& buffer);
+    /**
+         * Same as readState and writeState, but only for a single object.
+         */
+    void readObjectState(size_t object_idx, WorldStateBuffer& buffer);
+    void writeObjectState(size_t object_idx, const WorldStateBuffer& buffer);
+
+private:
+    WorldPtr _world;
+    WorldStateLayoutConstPtr _layout;
+    std::vector<ObjectPtr> _objects;
+    // scratch states to exchange data with the objects
+    std::vector<ObjectState, Eigen::aligned_allocator<ObjectState>> _object_states;
+
+    // throws a std::invalid_argument if the buffer's layout is not compatible with the layout of this accessor
+    void checkLayout(const WorldStateBuffer& buffer) const;
+    // writes the state of the given object without checking the layout of the buffer
+    void setObjectState(size_t object_idx, const WorldStateBuffer& buffer);
+};
+}
+
+#endif //SIM_ENV_WORLD_STATE_BUFFER_H
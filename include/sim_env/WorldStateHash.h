@@ -0,0 +1,149 @@
+//
+// Quantized hashing and deduplication of world states.
+//
+
+#ifndef SIM_ENV_WORLD_STATE_HASH_H
+#define SIM_ENV_WORLD_STATE_HASH_H
+
+#include <Eigen/Dense>
+#include <cstdint>
+#include <memory>
+#include <mutex>
+#include <sim_env/SimEnv.h>
+#include <sim_env/WorldStateBuffer.h>
+#include <unordered_map>
+#include <vector>
+
+namespace sim_env {
+class WorldStateHasher;
+typedef std::shared_ptr<WorldStateHasher> WorldStateHasherPtr;
+typedef std::shared_ptr<const WorldStateHasher> WorldStateHasherConstPtr;
+
+class ConcurrentWorldStateSet;
+typedef std::shared_ptr<ConcurrentWorldStateSet> ConcurrentWorldStateSetPtr;
+typedef std::shared_ptr<const ConcurrentWorldStateSet> ConcurrentWorldStateSetConstPtr;
+
+/**
+     * A WorldStateHasher computes hashes of world states that are stored in WorldStateBuffers.
+     * Each value of the buffer is quantized as key = floor(value / resolution), where the resolution is
+     * configurable per value, i.e. per pose component and per DOF of each object. Two states are considered
+     * equal if all their keys are equal. A resolution of 0 excludes a value from hashing and comparison.
+     * By default, positions and orientations (quaternion coefficients, see WorldStateLayout) are
+     * quantized with a resolution of 1e-3, DOF positions with 1e-3 and DOF velocities are ignored.
+     * Note that states that are arbitrarily close may still differ if they lie on different sides of
+     * a quantization boundary.
+     * Since q and -q describe the same rotation, orientations are not quantized with the sign stored in the
+     * buffer (qw >= 0), which flips for rotations of about 180 degrees (qw close to 0). Instead, the sign is
+     * chosen such that q has a non-negative dot product with a fixed reference quaternion. This moves the sign
+     * ambiguity to the orientations (nearly) orthogonal to the reference quaternion, which is chosen such that
+     * no rotation about a coordinate axis by a multiple of 90 degrees is among them.
+     */
+class WorldStateHasher {
+public:
+    explicit WorldStateHasher(WorldStateLayoutConstPtr layout);
+    ~WorldStateHasher();
+
+    WorldStateLayoutConstPtr getLayout() const;
+
+    /**
+         * Sets the resolution of the pose of all objects.
+         * @param position_resolution - resolution of the position in m
+         * @param orientation_resolution - resolution of the quaternion coefficients
+         */
+    void setPoseResolution(float position_resolution, float orientation_resolution);
+    /**
+         * Sets the resolution of all DOF positions / velocities of all objects.
+         */
+    void setDOFPositionResolution(float resolution);
+    void setDOFVelocityResolution(float resolution);
+    /**
+         * Sets the resolution of the pose or a single DOF of the given object.
+         */
+    void setPoseResolution(size_t object_idx, float position_resolution, float orientation_resolution);
+    void setDOFPositionResolution(size_t object_idx, unsigned int dof, float resolution);
+    void setDOFVelocityResolution(size_t object_idx, unsigned int dof, float resolution);
+    /**
+         * Sets the resolutions of all values at once. resolutions must have the size of the layout.
+         */
+    void setResolutions(const Eigen::VectorXf& resolutions);
+    Eigen::VectorXf getResolutions() const;
+
+    /**
+         * Computes the quantized keys of the given buffer. keys is only resized if its size differs.
+         */
+    void quantize(const WorldStateBuffer& buffer, std::vector<int64_t>& keys) const;
+    /**
+         * Returns the hash of the given keys or the given state.
+         */
+    uint64_t hash(const std::vector<int64_t>& keys) const;
+    uint64_t hash(const WorldStateBuffer& buffer) const;
+    /**
+         * Returns the hash of a WorldState. scratch is used to convert the state to the layout of this hasher.
+         */
+    uint64_t hash(const WorldState& state, WorldStateBuffer& scratch) const;
+    /**
+         * Returns the hash of the state of a single object, i.e. of its block within the buffer.
+         */
+    uint64_t hashObject(const WorldStateBuffer& buffer, size_t object_idx) const;
+    /**
+         * Returns whether two states are equal up to the resolution of this hasher.
+         */
+    bool equal(const WorldStateBuffer& a, const WorldStateBuffer& b) const;
+
+private:
+    WorldStateLayoutConstPtr _layout;
+    // 1 / resolution per value, 0 for ignored values
+    Eigen::VectorXf _inv_resolutions;
+
+    void setResolution(size_t offset, size_t num_values, float resolution);
+    void checkBuffer(const WorldStateBuffer& buffer) const;
+    // quantizes the block values of the given object into keys[0, entry.getSize())
+    void quantizeObject(const float* values, const WorldStateLayout::ObjectEntry& entry, int64_t* keys) const;
+};
+
+/**
+     * A thread-safe set of world states, deduplicated with a WorldStateHasher.
+     * The set is split into shards, each with its own mutex, so that threads inserting
+     * different states rarely contend. States are stored as quantized keys, i.e. insert
+     * compares the keys of states with equal hashes rather than full states.
+     */
+class ConcurrentWorldStateSet {
+public:
+    /**
+         * @param hasher - hasher that defines the equality of states
+         * @param num_shards - number of shards, rounded up to a power of two
+         */
+    explicit ConcurrentWorldStateSet(WorldStateHasherConstPtr hasher, size_t num_shards = 64);
+    ~ConcurrentWorldStateSet();
+    ConcurrentWorldStateSet(const ConcurrentWorldStateSet& other) = delete;
+    ConcurrentWorldStateSet& operator=(const ConcurrentWorldStateSet& other) = delete;
+
+    /**
+         * Inserts the given state.
+         * @return true if the state was inserted, false if an equal state is already contained
+         */
+    bool insert(const WorldStateBuffer& buffer);
+    bool contains(const WorldStateBuffer& buffer) const;
+    size_t size() const;
+    void clear();
+    WorldStateHasherConstPtr getHasher() const;
+
+private:
+    struct Shard {
+        mutable std::mutex mutex;
+        // maps hash to the index of the state's keys in keys
+        std::unordered_multimap<uint64_t, size_t> entries;
+        // keys of all states of this shard, one block of layout size per state
+        std::vector<int64_t> keys;
+    };
+
+    WorldStateHasherConstPtr _hasher;
+    size_t _num_keys;
+    size_t _shard_mask;
+    std::vector<Shard> _shards;
+
+    bool find(const Shard& shard, uint64_t hash, const std::vector<int64_t>& keys) const;
+};
+}
+
+#endif //SIM_ENV_WORLD_STATE_HASH_H
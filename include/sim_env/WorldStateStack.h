@@ -0,0 +1,125 @@
+//
+// Copy-on-write stack of world states.
+//
+
+#ifndef SIM_ENV_WORLD_STATE_STACK_H
+#define SIM_ENV_WORLD_STATE_STACK_H
+
+#include <memory>
+#include <sim_env/SimEnv.h>
+#include <sim_env/WorldStateBuffer.h>
+#include <string>
+#include <vector>
+
+namespace sim_env {
+class WorldStateStack;
+typedef std::shared_ptr<WorldStateStack> WorldStateStackPtr;
+typedef std::shared_ptr<const WorldStateStack> WorldStateStackConstPtr;
+
+/**
+     * A WorldStateStack is a reference implementation of World::saveState, World::restoreState
+     * and World::dropState that does not copy the whole world state on every save.
+     * Instead, the state of an object is copied lazily (copy-on-write): before an object is modified,
+     * the caller has to call touch(..) for it. The first touch of an object after a save records
+     * its current state in the top frame of the stack. Hence, each frame only contains the objects
+     * that were modified since the last save, and restoring a state costs O(number of modified objects)
+     * rather than O(size of the world).
+     * Frames are reused, so that saving, touching and restoring do not allocate memory once the stack
+     * has reached its maximal depth and width.
+     * Objects that are modified without being touched are not restored.
+     */
+class WorldStateStack {
+public:
+    /**
+         * @param world - the world whose state to save
+         * @param layout - layout of the world state, if nullptr a layout is created from the world
+         */
+    explicit WorldStateStack(WorldPtr world, WorldStateLayoutConstPtr layout = nullptr);
+    explicit WorldStateStack(WorldStateAccessorPtr accessor);
+    ~WorldStateStack();
+
+    /**
+         * Pushes a new, empty frame onto the stack.
+         */
+    void saveState();
+    /**
+         * Restores all objects that were touched since the last save and pops the top frame.
+         * @return true iff there was a state to restore to
+         */
+    bool restoreState();
+    /**
+         * Pops the top frame without restoring it. The recorded states are merged into the frame below,
+         * so that restoring that frame still restores all objects modified since its save.
+         * @return true iff there was a state to drop
+         */
+    bool dropState();
+    /**
+         * Removes all frames without restoring them.
+         */
+    void clear();
+
+    /**
+         * Announces that the given object is about to be modified. Must be called before modifying
+         * an object, if the stack is not empty. Touching an object multiple times is cheap.
+         * @param object_idx - index of the object in the layout (see WorldStateLayout::getObjectIndex)
+         */
+    void touch(size_t object_idx);
+    /**
+         * Same as touch(object_idx). Throws a std::invalid_argument if there is no object with this name.
+         */
+    void touch(const std::string& name);
+    void touchAll();
+    /**
+         * Returns whether the given object has been touched since the last save.
+         */
+    bool isTouched(size_t object_idx) const;
+
+    size_t getDepth() const;
+    WorldStateAccessorPtr getAccessor() const;
+
+    /**
+         * Returns the number of object states recorded in all frames of the stack.
+         */
+    size_t getNumRecordedObjects() const;
+    /**
+         * Returns the number of bytes used by the object states recorded in all frames.
+         */
+    size_t getMemoryUsage() const;
+    /**
+         * Returns the number of bytes reserved by this stack, including the capacity of unused frames.
+         */
+    size_t getReservedMemory() const;
+    /**
+         * Returns the number of bytes a stack of full snapshots with the current depth would use.
+         */
+    size_t getFullSnapshotMemoryUsage() const;
+
+private:
+    struct RecordedObject {
+        size_t object_idx;
+        // the depth of the frame that recorded this object before, 0 if none
+        size_t prev_depth;
+        // offset of the recorded state within the values of the frame
+        size_t offset;
+    };
+
+    struct Frame {
+        std::vector<RecordedObject> objects;
+        std::vector<float> values;
+    };
+
+    WorldStateAccessorPtr _accessor;
+    WorldStateLayoutConstPtr _layout;
+    WorldStateBuffer _scratch;
+    // _frames[0, _depth) are in use, the other frames are kept to reuse their memory
+    std::vector<Frame> _frames;
+    size_t _depth;
+    // for each object, the depth of the top-most frame that recorded it, 0 if none
+    std::vector<size_t> _recorded_depths;
+
+    void init();
+    void record(Frame& frame, size_t object_idx, size_t prev_depth, const float* values);
+};
+}
+
+#endif //SIM_ENV_WORLD_STATE_STACK_H
@@ -0,0 +1,476 @@
+#ifndef SIM_ENV_GRID_COMPRESSED_VOXEL_GRID_H
+#define SIM_ENV_GRID_COMPRESSED_VOXEL_GRID_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/grid/GridIO.h>
+#include <algorithm>
+#include <list>
+#include <memory>
+#include <mutex>
+#include <type_traits>
+#include <unordered_map>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * A CompressedVoxelGrid is a read-only voxel grid that stores its values run-length encoded.
+         * The grid is partitioned into bricks of BrickSize x BrickSize x BrickSize cells and each brick
+         * is encoded separately, so that large constant regions take up only a single run per brick.
+         * Accessing a cell decodes the brick containing it into an LRU cache of decoded bricks, which bounds
+         * the memory used for decoded values to cache_capacity bricks. Constant bricks are never decoded.
+         * A compressed grid can be stored to and mapped from disk (see save() and the path constructor), in which
+         * case the encoded data is accessed in place through a shared read-only memory mapping.
+         * Access is thread-safe. ValueType must be trivially copyable and comparable with operator==.
+         */
+        template<typename ScalarType, typename ValueType, size_t BrickSize = 8>
+        class CompressedVoxelGrid {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+                typedef std::vector<ValueType, Eigen::aligned_allocator<ValueType> > Brick;
+                static_assert(BrickSize > 0 and (BrickSize & (BrickSize - 1)) == 0, "BrickSize must be a power of two");
+                static_assert(not std::is_same<ValueType, bool>::value, "Use uint8_t instead of bool.");
+                static_assert(std::is_trivially_copyable<ValueType>::value,
+                              "ValueType must be trivially copyable to be stored and mapped.");
+                static const size_t DEFAULT_CACHE_CAPACITY = 1024;
+            private:
+                static constexpr size_t log2(size_t n) {
+                    return n <= 1 ? 0 : 1 + log2(n / 2);
+                }
+                static constexpr size_t BRICK_BITS = log2(BrickSize);
+                static constexpr size_t BRICK_MASK = BrickSize - 1;
+                static constexpr size_t BRICK_VOLUME = BrickSize * BrickSize * BrickSize;
+
+                struct CacheEntry {
+                    std::list<size_t>::iterator lru_position;
+                    Brick values;
+                };
+
+                VoxelGridMapping<ScalarType> _mapping;
+                size_t _x_size;
+                size_t _y_size;
+                size_t _z_size;
+                size_t _x_bricks;
+                size_t _xy_bricks;
+                size_t _num_bricks;
+                size_t _num_runs;
+                // Runs of brick b are _brick_offsets[b], ..., _brick_offsets[b + 1] - 1. Run r covers the in-brick
+                // indices [_run_ends[r - 1], _run_ends[r]) (starting at 0 for the first run of a brick).
+                // The pointers either point into the vectors below or into a mapped file.
+                const uint64_t* _brick_offsets;
+                const uint32_t* _run_ends;
+                const ValueType* _run_values;
+                std::vector<uint64_t> _own_brick_offsets;
+                std::vector<uint32_t> _own_run_ends;
+                std::vector<ValueType, Eigen::aligned_allocator<ValueType> > _own_run_values;
+                std::shared_ptr<grid_io::MappedFile> _file;
+                // cache of decoded bricks, most recently used first
+                mutable std::mutex _cache_mutex;
+                size_t _cache_capacity;
+                mutable std::list<size_t> _lru_list;
+                mutable std::unordered_map<size_t, CacheEntry> _cache;
+                mutable size_t _num_cache_misses;
+
+                void computeSizes() {
+                    auto& num_cells = _mapping.getNumCells();
+                    _x_size = num_cells[0];
+                    _y_size = num_cells[1];
+                    _z_size = num_cells[2];
+                    _x_bricks = (_x_size + BRICK_MASK) >> BRICK_BITS;
+                    _xy_bricks = _x_bricks * ((_y_size + BRICK_MASK) >> BRICK_BITS);
+                    _num_bricks = _xy_bricks * ((_z_size + BRICK_MASK) >> BRICK_BITS);
+                }
+
+                inline size_t getBrickKey(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return (ix >> BRICK_BITS) + (iy >> BRICK_BITS) * _x_bricks + (iz >> BRICK_BITS) * _xy_bricks;
+                }
+
+                inline size_t getInBrickIndex(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return (ix & BRICK_MASK) + ((iy & BRICK_MASK) << BRICK_BITS) + ((iz & BRICK_MASK) << (2 * BRICK_BITS));
+                }
+
+                void decodeBrick(size_t brick, Brick& values) const {
+                    values.resize(BRICK_VOLUME);
+                    uint32_t run_begin = 0;
+                    for (uint64_t r = _brick_offsets[brick]; r < _brick_offsets[brick + 1]; ++r) {
+                        std::fill(values.begin() + run_begin, values.begin() + _run_ends[r], _run_values[r]);
+                        run_begin = _run_ends[r];
+                    }
+                }
+
+                // Checks that the runs of all bricks are well-formed, so that decoding a brick of a mapped file
+                // never accesses memory out of bounds. Throws std::runtime_error otherwise.
+                void checkRuns(const std::string& path) const {
+                    bool b_valid = _brick_offsets[0] == 0 and _brick_offsets[_num_bricks] == _num_runs;
+                    for (size_t brick = 0; b_valid and brick < _num_bricks; ++brick) {
+                        const uint64_t first_run = _brick_offsets[brick];
+                        const uint64_t end_run = _brick_offsets[brick + 1];
+                        // each brick has at least one run, its runs are within the file and its run ends
+                        // strictly increase up to the brick volume
+                        b_valid = first_run < end_run and end_run <= _num_runs and
+                                  _run_ends[end_run - 1] == BRICK_VOLUME;
+                        uint32_t run_begin = 0;
+                        for (uint64_t r = first_run; b_valid and r < end_run; ++r) {
+                            b_valid = _run_ends[r] > run_begin;
+                            run_begin = _run_ends[r];
+                        }
+                    }
+                    if (not b_valid) {
+                        throw std::runtime_error("[sim_env::grid::CompressedVoxelGrid] The file " + path +
+                                                 " is corrupted.");
+                    }
+                }
+
+                // Removes the least recently used bricks until there are at most capacity cached bricks.
+                // Returns the values of the last evicted brick, so that its memory can be reused.
+                Brick evict(size_t capacity) const {
+                    Brick reusable;
+                    while (_cache.size() > capacity) {
+                        auto iter = _cache.find(_lru_list.back());
+                        reusable = std::move(iter->second.values);
+                        _cache.erase(iter);
+                        _lru_list.pop_back();
+                    }
+                    return reusable;
+                }
+
+                ValueType get(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    const size_t brick = getBrickKey(ix, iy, iz);
+                    const uint64_t first_run = _brick_offsets[brick];
+                    const uint64_t end_run = _brick_offsets[brick + 1];
+                    // constant bricks do not need to be decoded
+                    if (end_run - first_run == 1) {
+                        return _run_values[first_run];
+                    }
+                    const size_t in_brick_idx = getInBrickIndex(ix, iy, iz);
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    if (_cache_capacity == 0) {
+                        // without cache, search the run containing the cell
+                        const uint32_t* run = std::upper_bound(_run_ends + first_run, _run_ends + end_run,
+                                                               (uint32_t)in_brick_idx);
+                        return _run_values[run - _run_ends];
+                    }
+                    auto iter = _cache.find(brick);
+                    if (iter == _cache.end()) {
+                        ++_num_cache_misses;
+                        CacheEntry entry;
+                        entry.values = evict(_cache_capacity - 1);
+                        decodeBrick(brick, entry.values);
+                        _lru_list.push_front(brick);
+                        entry.lru_position = _lru_list.begin();
+                        iter = _cache.insert(std::make_pair(brick, std::move(entry))).first;
+                    } else {
+                        _lru_list.splice(_lru_list.begin(), _lru_list, iter->second.lru_position);
+                    }
+                    return iter->second.values[in_brick_idx];
+                }
+
+            public:
+                /**
+                 * Compresses the given voxel grid.
+                 * @param grid - the grid to compress
+                 * @param cache_capacity - maximal number of decoded bricks to keep in memory
+                 */
+                template<typename Layout>
+                explicit CompressedVoxelGrid(const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+                                             size_t cache_capacity = DEFAULT_CACHE_CAPACITY) :
+                    _mapping(grid.getMapping()),
+                    _cache_capacity(cache_capacity),
+                    _num_cache_misses(0)
+                {
+                    computeSizes();
+                    _own_brick_offsets.reserve(_num_bricks + 1);
+                    _own_brick_offsets.push_back(0);
+                    for (size_t bz = 0; bz < _z_size; bz += BrickSize) {
+                        for (size_t by = 0; by < _y_size; by += BrickSize) {
+                            for (size_t bx = 0; bx < _x_size; bx += BrickSize) {
+                                // cells beyond the grid repeat the last cell to not break runs
+                                uint32_t in_brick_idx = 0;
+                                for (size_t z = bz; z < bz + BrickSize; ++z) {
+                                    for (size_t y = by; y < by + BrickSize; ++y) {
+                                        for (size_t x = bx; x < bx + BrickSize; ++x) {
+                                            const ValueType& value = grid(std::min(x, _x_size - 1),
+                                                                          std::min(y, _y_size - 1),
+                                                                          std::min(z, _z_size - 1));
+                                            if (in_brick_idx > 0 and _own_run_values.back() == value) {
+                                                ++_own_run_ends.back();
+                                            } else {
+                                                _own_run_ends.push_back(in_brick_idx + 1);
+                                                _own_run_values.push_back(value);
+                                            }
+                                            ++in_brick_idx;
+                                        }
+                                    }
+                                }
+                                _own_brick_offsets.push_back(_own_run_ends.size());
+                            }
+                        }
+                    }
+                    _num_runs = _own_run_ends.size();
+                    _brick_offsets = _own_brick_offsets.data();
+                    _run_ends = _own_run_ends.data();
+                    _run_values = _own_run_values.data();
+                }
+
+                /**
+                 * Maps the compressed grid stored at path (see save()).
+                 * Throws std::runtime_error if the file can not be mapped or does not contain a compressed grid
+                 * with matching types and brick size.
+                 * @param path - the file to map
+                 * @param cache_capacity - maximal number of decoded bricks to keep in memory
+                 */
+                explicit CompressedVoxelGrid(const std::string& path, size_t cache_capacity = DEFAULT_CACHE_CAPACITY) :
+                    _mapping(Vector3s::Zero(), Vector3s::Ones(), ScalarType(1)),
+                    _file(std::make_shared<grid_io::MappedFile>(path)),
+                    _cache_capacity(cache_capacity),
+                    _num_cache_misses(0)
+                {
+                    grid_io::FileHeader header;
+                    if (_file->getSize() < sizeof(grid_io::FileHeader)) {
+                        throw std::runtime_error("[sim_env::grid::CompressedVoxelGrid] The file " + path +
+                                                 " is not a grid file.");
+                    }
+                    std::memcpy(&header, _file->getData(), sizeof(grid_io::FileHeader));
+                    grid_io::checkHeader(header, path);
+                    if (header.value_type != grid_io::TypeTagOf<ValueType>::value or
+                        header.value_size != sizeof(ValueType) or
+                        header.layout_type != grid_io::RLE_BRICKS or header.layout_parameter != BrickSize) {
+                        throw std::runtime_error("[sim_env::grid::CompressedVoxelGrid] The file " + path +
+                                                 " does not contain a compressed grid of the requested type.");
+                    }
+                    _mapping = grid_io::createMapping<ScalarType>(header, path);
+                    computeSizes();
+                    _num_runs = header.storage_size;
+                    uint64_t offsets_position = header.data_offset;
+                    uint64_t ends_position = grid_io::alignOffset(offsets_position + (_num_bricks + 1) * sizeof(uint64_t));
+                    uint64_t values_position = grid_io::alignOffset(ends_position + _num_runs * sizeof(uint32_t));
+                    // the first check prevents the position computations from overflowing
+                    if (_num_runs > _file->getSize() or _num_bricks >= _file->getSize() or
+                        values_position + _num_runs * sizeof(ValueType) > _file->getSize()) {
+                        throw std::runtime_error("[sim_env::grid::CompressedVoxelGrid] The file " + path +
+                                                 " is truncated.");
+                    }
+                    _brick_offsets = reinterpret_cast<const uint64_t*>(_file->getData() + offsets_position);
+                    _run_ends = reinterpret_cast<const uint32_t*>(_file->getData() + ends_position);
+                    _run_values = reinterpret_cast<const ValueType*>(_file->getData() + values_position);
+                    checkRuns(path);
+                }
+
+                // the cache mutex and the pointers into the own storage prevent copying
+                CompressedVoxelGrid(const CompressedVoxelGrid& other) = delete;
+                CompressedVoxelGrid& operator=(const CompressedVoxelGrid& other) = delete;
+                ~CompressedVoxelGrid() = default;
+
+                /**
+                 * Stores this grid in the binary grid format (see GridIO.h) with layout RLE_BRICKS.
+                 * Throws std::runtime_error on failure.
+                 */
+                void save(const std::string& path) const {
+                    grid_io::FileHeader header;
+                    grid_io::initHeader(header);
+                    header.value_type = grid_io::TypeTagOf<ValueType>::value;
+                    header.value_size = sizeof(ValueType);
+                    header.layout_type = grid_io::RLE_BRICKS;
+                    header.layout_parameter = BrickSize;
+                    header.x_size = _x_size;
+                    header.y_size = _y_size;
+                    header.z_size = _z_size;
+                    header.storage_size = _num_runs;
+                    grid_io::fillMappingHeader(_mapping, header);
+                    std::vector<grid_io::DataBlock> blocks;
+                    blocks.push_back(grid_io::DataBlock{_brick_offsets, (_num_bricks + 1) * sizeof(uint64_t)});
+                    blocks.push_back(grid_io::DataBlock{_run_ends, _num_runs * sizeof(uint32_t)});
+                    blocks.push_back(grid_io::DataBlock{_run_values, _num_runs * sizeof(ValueType)});
+                    grid_io::writeFile(path, header, blocks);
+                }
+
+                /**
+                 * Writes all values of this grid into the given grid, which must have the same size.
+                 */
+                template<typename Layout>
+                void decompress(VoxelGrid<ScalarType, ValueType, Layout>& grid) const {
+                    if (grid.getXSize() != _x_size or grid.getYSize() != _y_size or grid.getZSize() != _z_size) {
+                        throw std::invalid_argument("The output grid must have the same size as the compressed grid.");
+                    }
+                    Brick values;
+                    for (size_t bz = 0; bz < _z_size; bz += BrickSize) {
+                        for (size_t by = 0; by < _y_size; by += BrickSize) {
+                            for (size_t bx = 0; bx < _x_size; bx += BrickSize) {
+                                decodeBrick(getBrickKey(bx, by, bz), values);
+                                size_t z_end = std::min(bz + BrickSize, _z_size);
+                                size_t y_end = std::min(by + BrickSize, _y_size);
+                                size_t x_end = std::min(bx + BrickSize, _x_size);
+                                for (size_t z = bz; z < z_end; ++z) {
+                                    for (size_t y = by; y < y_end; ++y) {
+                                        for (size_t x = bx; x < x_end; ++x) {
+                                            grid(x, y, z) = values[getInBrickIndex(x, y, z)];
+                                        }
+                                    }
+                                }
+                            }
+                        }
+                    }
+                }
+
+                inline size_t getXSize() const {
+                    return _x_size;
+                }
+
+                inline size_t getYSize() const {
+                    return _y_size;
+                }
+
+                inline size_t getZSize() const {
+                    return _z_size;
+                }
+
+                inline bool inBounds(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return ix < _x_size && iy < _y_size && iz < _z_size;
+                }
+
+                inline bool inBounds(const long& ix, const long& iy, const long& iz) const {
+                    return ix >= 0 and iy >= 0 and iz >= 0 and ix < _x_size and iy < _y_size and iz < _z_size;
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                inline bool inBounds(const UnsignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                /*
+                 * Values are returned by value, since the decoded brick may be evicted from the cache at any time.
+                 */
+                ValueType operator()(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return get(ix, iy, iz);
+                }
+
+                ValueType operator()(const UnsignedIndex& idx) const {
+                    return get(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType at(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                ValueType at(const long& ix, const long& iy, const long& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                ValueType at(const UnsignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType at(const SignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                size_t getNumBricks() const {
+                    return _num_bricks;
+                }
+
+                size_t getNumRuns() const {
+                    return _num_runs;
+                }
+
+                /*
+                 * Returns the number of bytes of the encoded data.
+                 */
+                size_t getCompressedMemory() const {
+                    return (_num_bricks + 1) * sizeof(uint64_t) + _num_runs * (sizeof(uint32_t) + sizeof(ValueType));
+                }
+
+                size_t getCacheCapacity() const {
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    return _cache_capacity;
+                }
+
+                /*
+                 * Sets the maximal number of decoded bricks to keep in memory. With a capacity of 0, each access
+                 * searches the run containing the cell instead of decoding the brick.
+                 */
+                void setCacheCapacity(size_t capacity) {
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    _cache_capacity = capacity;
+                    evict(capacity);
+                }
+
+                size_t getNumCachedBricks() const {
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    return _cache.size();
+                }
+
+                /*
+                 * Returns how many bricks had to be decoded since construction.
+                 */
+                size_t getNumCacheMisses() const {
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    return _num_cache_misses;
+                }
+
+                void clearCache() {
+                    std::lock_guard<std::mutex> lock(_cache_mutex);
+                    evict(0);
+                }
+
+                UnsignedIndexGenerator getIndexGenerator() const {
+                    return UnsignedIndexGenerator(_x_size, _y_size, _z_size);
+                }
+
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    return _mapping.getCellIdx(position);
+                }
+
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    return _mapping.getValidCellIdx(position, is_valid);
+                }
+
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
+                }
+
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                ScalarType getCellSize() const {
+                    return _mapping.getCellSize();
+                }
+
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    _mapping.getBoundingBox(min_point, max_point);
+                }
+
+                /**
+                 * Sets the transformation for this grid. The given transformation is expected
+                 * to only consist of a rotation and translation.
+                 */
+                void setTransform(const Eigen::Transform<ScalarType, 3, Eigen::Affine>& tf) {
+                    _mapping.setTransform(tf);
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
+                    return _mapping.getTransform();
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
+                    return _mapping.getInvTransform();
+                }
+
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_COMPRESSED_VOXEL_GRID_H
@@ -0,0 +1,218 @@
+#ifndef SIM_ENV_GRID_CONCURRENT_GRID3D_H
+#define SIM_ENV_GRID_CONCURRENT_GRID3D_H
+
+#include <sim_env/Grid.h>
+#include <algorithm>
+#include <mutex>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * A ConcurrentGrid3D provides thread-safe updates of the cells of an existing Grid3D (or VoxelGrid),
+         * so that multiple threads can integrate into the same grid without locking the whole grid.
+         *  - For arithmetic value types, atomicAdd, atomicMax, atomicMin and atomicUpdate modify single cells
+         *    lock-free using compare-and-swap on the storage of the grid.
+         *  - For any value type, update(..) calls a function on a cell while holding the lock of the brick of
+         *    2^brick_bits cells per axis that contains it. Bricks are mapped to a fixed number of striped
+         *    mutexes, so that threads only contend if they update nearby cells (or bricks that share a stripe).
+         * Atomic operations use relaxed memory ordering, i.e. they are only guaranteed to be visible to other
+         * threads after synchronization, e.g. after parallelFor returns. Atomic and locked updates of the same
+         * cell must not be mixed, and the grid must not be accessed directly or resized while it is updated
+         * concurrently.
+         */
+        template<typename ValueType, typename Layout = RowMajorLayout>
+        class ConcurrentGrid3D {
+            public:
+                /*
+                 * @param grid - the grid to update, must outlive this object
+                 * @param brick_bits - log2 of the number of cells per brick along each axis
+                 * @param num_stripes - number of mutexes, rounded up to a power of two
+                 */
+                explicit ConcurrentGrid3D(Grid3D<ValueType, Layout>& grid, unsigned int brick_bits = 3,
+                                          size_t num_stripes = 1024) :
+                    _grid(grid),
+                    _brick_bits(brick_bits),
+                    _stripe_mask(roundUpToPowerOfTwo(num_stripes) - 1),
+                    _locks(_stripe_mask + 1)
+                {
+                }
+
+                ConcurrentGrid3D(const ConcurrentGrid3D& other) = delete;
+                ConcurrentGrid3D& operator=(const ConcurrentGrid3D& other) = delete;
+
+                Grid3D<ValueType, Layout>& getGrid() {
+                    return _grid;
+                }
+
+                const Grid3D<ValueType, Layout>& getGrid() const {
+                    return _grid;
+                }
+
+                size_t getNumStripes() const {
+                    return _locks.size();
+                }
+
+                /*
+                 * Atomically reads the value of the given cell.
+                 */
+                ValueType load(const UnsignedIndex& idx) const {
+                    checkAtomic();
+                    ValueType result;
+                    __atomic_load(&_grid(checkIndex(idx)), &result, __ATOMIC_RELAXED);
+                    return result;
+                }
+
+                /*
+                 * Atomically sets the value of the given cell.
+                 */
+                void store(const UnsignedIndex& idx, ValueType value) {
+                    checkAtomic();
+                    __atomic_store(&_grid(checkIndex(idx)), &value, __ATOMIC_RELAXED);
+                }
+
+                /*
+                 * Atomically sets the given cell to op(old value) and returns the old value.
+                 * op may be called multiple times if other threads update the cell concurrently and
+                 * must hence not have side effects.
+                 */
+                template<typename UnaryOp>
+                ValueType atomicUpdate(const UnsignedIndex& idx, UnaryOp op) {
+                    checkAtomic();
+                    ValueType* cell = &_grid(checkIndex(idx));
+                    ValueType expected;
+                    __atomic_load(cell, &expected, __ATOMIC_RELAXED);
+                    ValueType desired = op(expected);
+                    // on failure expected is set to the current value
+                    while (not __atomic_compare_exchange(cell, &expected, &desired, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {
+                        desired = op(expected);
+                    }
+                    return expected;
+                }
+
+                /*
+                 * Atomically adds delta to the given cell and returns the old value.
+                 */
+                ValueType atomicAdd(const UnsignedIndex& idx, const ValueType& delta) {
+                    return atomicAddImpl(idx, delta, std::is_integral<ValueType>());
+                }
+
+                /*
+                 * Atomically sets the given cell to the maximum of its value and value and returns the old value.
+                 */
+                ValueType atomicMax(const UnsignedIndex& idx, const ValueType& value) {
+                    checkAtomic();
+                    ValueType* cell = &_grid(checkIndex(idx));
+                    ValueType expected;
+                    ValueType desired = value;
+                    __atomic_load(cell, &expected, __ATOMIC_RELAXED);
+                    // only write if the value increases
+                    while (expected < desired and
+                           not __atomic_compare_exchange(cell, &expected, &desired, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+                    return expected;
+                }
+
+                /*
+                 * Atomically sets the given cell to the minimum of its value and value and returns the old value.
+                 */
+                ValueType atomicMin(const UnsignedIndex& idx, const ValueType& value) {
+                    checkAtomic();
+                    ValueType* cell = &_grid(checkIndex(idx));
+                    ValueType expected;
+                    ValueType desired = value;
+                    __atomic_load(cell, &expected, __ATOMIC_RELAXED);
+                    while (desired < expected and
+                           not __atomic_compare_exchange(cell, &expected, &desired, true,
+                                                         __ATOMIC_RELAXED, __ATOMIC_RELAXED)) {}
+                    return expected;
+                }
+
+                /*
+                 * Calls fn(ValueType& value) on the given cell while holding the lock of its brick.
+                 * Works for any value type.
+                 */
+                template<typename Function>
+                void update(const UnsignedIndex& idx, Function fn) {
+                    checkIndex(idx);
+                    std::lock_guard<std::mutex> lock(_locks[getStripe(idx)]);
+                    fn(_grid(idx));
+                }
+
+                /*
+                 * Calls fn(const UnsignedIndex& idx, ValueType& value) for all cells of the given brick
+                 * (clipped to the grid) while holding its lock. Updating all cells of a brick at once
+                 * amortizes the locking when a thread writes many nearby cells.
+                 * @param idx - index of any cell within the brick
+                 */
+                template<typename Function>
+                void updateBrick(const UnsignedIndex& idx, Function fn) {
+                    checkIndex(idx);
+                    const size_t brick_size = size_t(1) << _brick_bits;
+                    const UnsignedIndex base((idx.ix >> _brick_bits) << _brick_bits, (idx.iy >> _brick_bits) << _brick_bits,
+                                             (idx.iz >> _brick_bits) << _brick_bits);
+                    const size_t x_end = std::min(base.ix + brick_size, _grid.getXSize());
+                    const size_t y_end = std::min(base.iy + brick_size, _grid.getYSize());
+                    const size_t z_end = std::min(base.iz + brick_size, _grid.getZSize());
+                    std::lock_guard<std::mutex> lock(_locks[getStripe(idx)]);
+                    UnsignedIndex cell;
+                    for (cell.iz = base.iz; cell.iz < z_end; ++cell.iz) {
+                        for (cell.iy = base.iy; cell.iy < y_end; ++cell.iy) {
+                            for (cell.ix = base.ix; cell.ix < x_end; ++cell.ix) {
+                                fn(const_cast<const UnsignedIndex&>(cell), _grid(cell));
+                            }
+                        }
+                    }
+                }
+
+            private:
+                Grid3D<ValueType, Layout>& _grid;
+                unsigned int _brick_bits;
+                size_t _stripe_mask;
+                std::vector<std::mutex> _locks;
+
+                static size_t roundUpToPowerOfTwo(size_t n) {
+                    size_t result = 1;
+                    while (result < n) {
+                        result <<= 1;
+                    }
+                    return result;
+                }
+
+                static void checkAtomic() {
+                    static_assert(std::is_arithmetic<ValueType>::value,
+                                  "Atomic operations are only supported for arithmetic value types.");
+                    static_assert(sizeof(ValueType) <= 8, "Atomic operations require a lock-free value type.");
+                }
+
+                const UnsignedIndex& checkIndex(const UnsignedIndex& idx) const {
+                    if (not _grid.inBounds(idx)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return idx;
+                }
+
+                inline size_t getStripe(const UnsignedIndex& idx) const {
+                    // hash of the brick index, see Teschner et al., "Optimized Spatial Hashing for
+                    // Collision Detection of Deformable Objects", 2003
+                    size_t hash = ((idx.ix >> _brick_bits) * 73856093u) ^ ((idx.iy >> _brick_bits) * 19349663u) ^
+                                  ((idx.iz >> _brick_bits) * 83492791u);
+                    return hash & _stripe_mask;
+                }
+
+                ValueType atomicAddImpl(const UnsignedIndex& idx, const ValueType& delta, std::true_type /* integral */) {
+                    checkAtomic();
+                    return __atomic_fetch_add(&_grid(checkIndex(idx)), delta, __ATOMIC_RELAXED);
+                }
+
+                ValueType atomicAddImpl(const UnsignedIndex& idx, const ValueType& delta, std::false_type /* integral */) {
+                    return atomicUpdate(idx, [&delta](const ValueType& value) { return value + delta; });
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_CONCURRENT_GRID3D_H
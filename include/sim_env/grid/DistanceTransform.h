@@ -0,0 +1,189 @@
+#ifndef SIM_ENV_GRID_DISTANCE_TRANSFORM_H
+#define SIM_ENV_GRID_DISTANCE_TRANSFORM_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        namespace distance_transform {
+            /**
+             * Computes the one-dimensional squared Euclidean distance transform of the sampled function f
+             * following Felzenszwalb and Huttenlocher, "Distance Transforms of Sampled Functions", 2012.
+             * The input is read from and the output written to data[offset + i * stride], i = 0, ..., n - 1.
+             * The vectors f, v and z are scratch buffers of sizes >= n, n and n + 1 respectively.
+             */
+            template<typename ScalarType>
+            void squaredDistance1D(ScalarType* data, size_t offset, size_t stride, size_t n,
+                                   ScalarType* f, long* v, ScalarType* z) {
+                const ScalarType inf = std::numeric_limits<ScalarType>::infinity();
+                for (size_t i = 0; i < n; ++i) {
+                    f[i] = data[offset + i * stride];
+                }
+                long k = 0;
+                v[0] = 0;
+                z[0] = -inf;
+                z[1] = inf;
+                for (long q = 1; q < (long)n; ++q) {
+                    // z[0] = -inf, hence k never drops below 0
+                    ScalarType s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+                    while (s <= z[k]) {
+                        --k;
+                        s = ((f[q] + q * q) - (f[v[k]] + v[k] * v[k])) / (2 * q - 2 * v[k]);
+                    }
+                    ++k;
+                    v[k] = q;
+                    z[k] = s;
+                    z[k + 1] = inf;
+                }
+                k = 0;
+                for (long q = 0; q < (long)n; ++q) {
+                    while (z[k + 1] < q) {
+                        ++k;
+                    }
+                    ScalarType diff = q - v[k];
+                    data[offset + q * stride] = diff * diff + f[v[k]];
+                }
+            }
+
+            /**
+             * Computes the squared Euclidean distance transform of the given row-major volume in place.
+             * On input, a cell must hold 0 for source cells and a large value (see getFarValue()) otherwise.
+             * On output, each cell holds the squared distance (in cells) to the closest source cell.
+             * The three axis passes are each parallelized over slices of the volume.
+             */
+            template<typename ScalarType>
+            void squaredDistanceTransform(std::vector<ScalarType>& volume, size_t x_size, size_t y_size, size_t z_size,
+                                          unsigned int num_threads = 0) {
+                const size_t xy_size = x_size * y_size;
+                const size_t max_size = std::max(x_size, std::max(y_size, z_size));
+                ScalarType* data = volume.data();
+                // runs the 1D transform for all lines along one axis within the given slices
+                auto run_pass = [&](size_t slice_begin, size_t slice_end, size_t num_lines, size_t n,
+                                    size_t stride, size_t slice_stride, size_t line_stride) {
+                    std::vector<ScalarType> f(max_size);
+                    std::vector<long> v(max_size);
+                    std::vector<ScalarType> z(max_size + 1);
+                    for (size_t slice = slice_begin; slice < slice_end; ++slice) {
+                        for (size_t line = 0; line < num_lines; ++line) {
+                            squaredDistance1D(data, slice * slice_stride + line * line_stride, stride, n,
+                                              f.data(), v.data(), z.data());
+                        }
+                    }
+                };
+                // x pass, parallel over z slices
+                utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                    run_pass(begin, end, y_size, x_size, 1, xy_size, x_size);
+                }, num_threads);
+                // y pass, parallel over z slices
+                utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                    run_pass(begin, end, x_size, y_size, x_size, xy_size, 1);
+                }, num_threads);
+                // z pass, parallel over y slices
+                utils::parallel::parallelFor(0, y_size, [&](size_t begin, size_t end) {
+                    run_pass(begin, end, x_size, z_size, xy_size, x_size, 1);
+                }, num_threads);
+            }
+
+            /**
+             * Returns the value used to mark non-source cells in squaredDistanceTransform. It is finite
+             * to avoid inf - inf in the computation of parabola intersections, but larger than any
+             * squared distance that can occur in a grid.
+             */
+            template<typename ScalarType>
+            inline ScalarType getFarValue() {
+                return std::sqrt(std::numeric_limits<ScalarType>::max()) / ScalarType(4);
+            }
+        }
+
+        /**
+         * Computes the signed Euclidean distance field of the given grid in linear time.
+         * A cell is considered occupied, if is_occupied(value) returns true for its value.
+         * For free cells the distance field stores the distance from the cell's center to the center of the
+         * closest occupied cell, and for occupied cells the negative distance to the center of the closest free cell.
+         * If there is no occupied (free) cell at all, the distance of free (occupied) cells is +inf (-inf).
+         * The distances are in units of the grid, i.e. scaled by its cell size.
+         * @param grid - input grid
+         * @param is_occupied - unary predicate on ValueType
+         * @param distance_field - output grid; must have the same number of cells as grid
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ScalarType, typename ValueType, typename Layout, typename Predicate>
+        void computeSignedDistanceField(const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+                                        const Predicate& is_occupied,
+                                        VoxelGrid<ScalarType, ScalarType, Layout>& distance_field,
+                                        unsigned int num_threads = 0) {
+            const size_t x_size = grid.getXSize();
+            const size_t y_size = grid.getYSize();
+            const size_t z_size = grid.getZSize();
+            if (distance_field.getXSize() != x_size or distance_field.getYSize() != y_size
+                or distance_field.getZSize() != z_size) {
+                throw std::invalid_argument("The distance field must have the same size as the input grid.");
+            }
+            const size_t xy_size = x_size * y_size;
+            const ScalarType far_value = distance_transform::getFarValue<ScalarType>();
+            // squared distances to the closest occupied and the closest free cell
+            std::vector<ScalarType> outside(xy_size * z_size);
+            std::vector<ScalarType> inside(xy_size * z_size);
+            utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                for (size_t z = begin; z < end; ++z) {
+                    for (size_t y = 0; y < y_size; ++y) {
+                        for (size_t x = 0; x < x_size; ++x) {
+                            size_t i = x + y * x_size + z * xy_size;
+                            bool occupied = is_occupied(grid(x, y, z));
+                            outside[i] = occupied ? ScalarType(0) : far_value;
+                            inside[i] = occupied ? far_value : ScalarType(0);
+                        }
+                    }
+                }
+            }, num_threads);
+            distance_transform::squaredDistanceTransform(outside, x_size, y_size, z_size, num_threads);
+            distance_transform::squaredDistanceTransform(inside, x_size, y_size, z_size, num_threads);
+            const ScalarType cell_size = grid.getCellSize();
+            const ScalarType inf = std::numeric_limits<ScalarType>::infinity();
+            // Any real squared distance is below max_size^2 * 3. Larger values stem from far_value.
+            const ScalarType far_threshold = far_value / ScalarType(2);
+            utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                for (size_t z = begin; z < end; ++z) {
+                    for (size_t y = 0; y < y_size; ++y) {
+                        for (size_t x = 0; x < x_size; ++x) {
+                            size_t i = x + y * x_size + z * xy_size;
+                            ScalarType value;
+                            if (inside[i] == ScalarType(0)) {
+                                value = outside[i] >= far_threshold ? inf : cell_size * std::sqrt(outside[i]);
+                            } else {
+                                value = inside[i] >= far_threshold ? -inf : -cell_size * std::sqrt(inside[i]);
+                            }
+                            distance_field(x, y, z) = value;
+                        }
+                    }
+                }
+            }, num_threads);
+        }
+
+        /**
+         * Convenience version of computeSignedDistanceField that creates the distance field with the same
+         * bounding box, cell size and transform as grid. A cell is considered occupied if its value is
+         * greater or equal than occupancy_threshold.
+         */
+        template<typename ScalarType, typename ValueType, typename Layout>
+        VoxelGrid<ScalarType, ScalarType, Layout> computeSignedDistanceField(
+            const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+            const ValueType& occupancy_threshold,
+            unsigned int num_threads = 0) {
+            typename VoxelGrid<ScalarType, ScalarType, Layout>::Vector3s min_point, max_point;
+            grid.getBoundingBox(min_point, max_point);
+            VoxelGrid<ScalarType, ScalarType, Layout> distance_field(min_point, max_point, grid.getCellSize());
+            distance_field.setTransform(grid.getTransform());
+            computeSignedDistanceField(grid,
+                [&occupancy_threshold](const ValueType& value) { return value >= occupancy_threshold; },
+                distance_field, num_threads);
+            return distance_field;
+        }
+    }
+}
+#endif //SIM_ENV_GRID_DISTANCE_TRANSFORM_H
@@ -0,0 +1,333 @@
+#ifndef SIM_ENV_GRID_DYNAMIC_DISTANCE_FIELD_H
+#define SIM_ENV_GRID_DYNAMIC_DISTANCE_FIELD_H
+
+#include <sim_env/Grid.h>
+#include <array>
+#include <cmath>
+#include <functional>
+#include <queue>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * A DynamicDistanceField maintains the (unsigned) Euclidean distance from each cell of a voxel grid to its
+         * closest occupied cell. Instead of recomputing the whole field, changes in occupancy are propagated
+         * with the dynamic brushfire algorithm described in
+         *  B. Lau, C. Sprunk and W. Burgard, "Efficient grid-based spatial representations for robot navigation
+         *  in dynamic environments", Robotics and Autonomous Systems, 2013.
+         * An update only touches cells whose closest obstacle changes. Distances are capped at a maximal
+         * distance, which additionally bounds the region affected by an update.
+         */
+        template<typename ScalarType, typename Layout = RowMajorLayout>
+        class DynamicDistanceField {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+            private:
+                enum class QueueState : unsigned char {
+                    None, Queued, Processed
+                };
+
+                struct CellData {
+                    int obst_x; // index of the closest obstacle, obst_x < 0 if there is none
+                    int obst_y;
+                    int obst_z;
+                    int sq_dist; // squared distance in cells to the closest obstacle
+                    unsigned int touch_stamp; // update in which this cell was touched last
+                    bool occupied;
+                    bool needs_raise;
+                    QueueState queue_state;
+                };
+
+                struct QueueEntry {
+                    int sq_dist;
+                    unsigned int x;
+                    unsigned int y;
+                    unsigned int z;
+                    bool operator>(const QueueEntry& other) const {
+                        return sq_dist > other.sq_dist;
+                    }
+                };
+
+                VoxelGrid<ScalarType, ScalarType, Layout> _distance_field;
+                Grid3D<CellData, Layout> _cells;
+                ScalarType _max_distance;
+                int _max_sq_dist;
+                unsigned int _update_stamp;
+                std::priority_queue<QueueEntry, std::vector<QueueEntry>, std::greater<QueueEntry> > _open;
+                std::vector<UnsignedIndex> _touched_cells;
+                std::vector<std::array<int, 3> > _neighbor_offsets;
+
+                void touch(CellData& cell, const size_t& x, const size_t& y, const size_t& z) {
+                    if (cell.touch_stamp != _update_stamp) {
+                        cell.touch_stamp = _update_stamp;
+                        _touched_cells.push_back(UnsignedIndex(x, y, z));
+                    }
+                }
+
+                void push(CellData& cell, const size_t& x, const size_t& y, const size_t& z) {
+                    QueueEntry entry;
+                    entry.sq_dist = cell.sq_dist;
+                    entry.x = (unsigned int)x;
+                    entry.y = (unsigned int)y;
+                    entry.z = (unsigned int)z;
+                    _open.push(entry);
+                    cell.queue_state = QueueState::Queued;
+                }
+
+                void setObstacle(const UnsignedIndex& idx) {
+                    CellData& cell = _cells(idx);
+                    if (cell.occupied) return;
+                    cell.occupied = true;
+                    cell.obst_x = (int)idx.ix;
+                    cell.obst_y = (int)idx.iy;
+                    cell.obst_z = (int)idx.iz;
+                    cell.sq_dist = 0;
+                    cell.needs_raise = false;
+                    touch(cell, idx.ix, idx.iy, idx.iz);
+                    push(cell, idx.ix, idx.iy, idx.iz);
+                }
+
+                void removeObstacle(const UnsignedIndex& idx) {
+                    CellData& cell = _cells(idx);
+                    if (not cell.occupied) return;
+                    cell.occupied = false;
+                    cell.obst_x = cell.obst_y = cell.obst_z = -1;
+                    cell.sq_dist = _max_sq_dist;
+                    cell.needs_raise = true;
+                    touch(cell, idx.ix, idx.iy, idx.iz);
+                    QueueEntry entry{0, (unsigned int)idx.ix, (unsigned int)idx.iy, (unsigned int)idx.iz};
+                    _open.push(entry);
+                    cell.queue_state = QueueState::Queued;
+                }
+
+                inline bool isValidObstacle(const CellData& cell) const {
+                    return cell.obst_x >= 0 and _cells(cell.obst_x, cell.obst_y, cell.obst_z).occupied;
+                }
+
+                // Invalidates all neighbors whose closest obstacle has been removed.
+                void raise(const QueueEntry& entry) {
+                    for (auto& offset : _neighbor_offsets) {
+                        long nx = (long)entry.x + offset[0];
+                        long ny = (long)entry.y + offset[1];
+                        long nz = (long)entry.z + offset[2];
+                        if (not _cells.inBounds(nx, ny, nz)) continue;
+                        CellData& neighbor = _cells(nx, ny, nz);
+                        if (neighbor.obst_x < 0 or neighbor.needs_raise) continue;
+                        if (not isValidObstacle(neighbor)) {
+                            // queue with the old distance so that the raise wave front is processed in order
+                            push(neighbor, nx, ny, nz);
+                            neighbor.needs_raise = true;
+                            neighbor.obst_x = neighbor.obst_y = neighbor.obst_z = -1;
+                            neighbor.sq_dist = _max_sq_dist;
+                            touch(neighbor, nx, ny, nz);
+                        } else if (neighbor.queue_state != QueueState::Queued) {
+                            // this neighbor may now be closer to some cell in the raised region
+                            push(neighbor, nx, ny, nz);
+                        }
+                    }
+                }
+
+                // Propagates the obstacle of the given cell to its neighbors.
+                void lower(const QueueEntry& entry, const CellData& cell) {
+                    for (auto& offset : _neighbor_offsets) {
+                        long nx = (long)entry.x + offset[0];
+                        long ny = (long)entry.y + offset[1];
+                        long nz = (long)entry.z + offset[2];
+                        if (not _cells.inBounds(nx, ny, nz)) continue;
+                        CellData& neighbor = _cells(nx, ny, nz);
+                        if (neighbor.needs_raise) continue;
+                        int dx = (int)nx - cell.obst_x;
+                        int dy = (int)ny - cell.obst_y;
+                        int dz = (int)nz - cell.obst_z;
+                        int new_sq_dist = dx * dx + dy * dy + dz * dz;
+                        bool overwrite = new_sq_dist < neighbor.sq_dist;
+                        if (not overwrite and new_sq_dist == neighbor.sq_dist) {
+                            overwrite = neighbor.obst_x < 0 or not isValidObstacle(neighbor);
+                        }
+                        if (overwrite) {
+                            neighbor.sq_dist = new_sq_dist;
+                            neighbor.obst_x = cell.obst_x;
+                            neighbor.obst_y = cell.obst_y;
+                            neighbor.obst_z = cell.obst_z;
+                            touch(neighbor, nx, ny, nz);
+                            push(neighbor, nx, ny, nz);
+                        }
+                    }
+                }
+
+                void propagate() {
+                    while (not _open.empty()) {
+                        QueueEntry entry = _open.top();
+                        _open.pop();
+                        CellData& cell = _cells(entry.x, entry.y, entry.z);
+                        if (cell.queue_state == QueueState::Processed) continue;
+                        if (cell.needs_raise) {
+                            raise(entry);
+                            cell.needs_raise = false;
+                            cell.queue_state = QueueState::Processed;
+                        } else if (isValidObstacle(cell)) {
+                            cell.queue_state = QueueState::Processed;
+                            lower(entry, cell);
+                        } else {
+                            cell.queue_state = QueueState::Processed;
+                        }
+                    }
+                }
+
+                void initialize() {
+                    _max_sq_dist = (int)std::ceil(std::pow(_max_distance / _distance_field.getCellSize(), 2));
+                    _max_sq_dist = std::max(_max_sq_dist, 1);
+                    CellData empty_cell;
+                    empty_cell.obst_x = empty_cell.obst_y = empty_cell.obst_z = -1;
+                    empty_cell.sq_dist = _max_sq_dist;
+                    empty_cell.touch_stamp = 0;
+                    empty_cell.occupied = false;
+                    empty_cell.needs_raise = false;
+                    empty_cell.queue_state = QueueState::None;
+                    std::fill(_cells.begin(), _cells.end(), empty_cell);
+                    std::fill(_distance_field.begin(), _distance_field.end(), _max_distance);
+                    _update_stamp = 0;
+                    for (int dz = -1; dz <= 1; ++dz) {
+                        for (int dy = -1; dy <= 1; ++dy) {
+                            for (int dx = -1; dx <= 1; ++dx) {
+                                if (dx != 0 or dy != 0 or dz != 0) {
+                                    _neighbor_offsets.push_back({{dx, dy, dz}});
+                                }
+                            }
+                        }
+                    }
+                }
+
+            public:
+                /**
+                 * Creates a new distance field without any occupied cells.
+                 * @param min_point, max_point, cell_size - see VoxelGrid
+                 * @param max_distance - maximal distance to compute; cells that are further away from any
+                 *          obstacle have distance max_distance.
+                 */
+                DynamicDistanceField(const Vector3s& min_point, const Vector3s& max_point,
+                                     const ScalarType& cell_size, const ScalarType& max_distance) :
+                    _distance_field(min_point, max_point, cell_size),
+                    _cells(_distance_field.getXSize(), _distance_field.getYSize(), _distance_field.getZSize()),
+                    _max_distance(max_distance)
+                {
+                    initialize();
+                }
+
+                /**
+                 * Creates a new distance field without any occupied cells that has the same bounding box,
+                 * cell size and transform as the given mapping (e.g. VoxelGrid::getMapping()).
+                 */
+                DynamicDistanceField(const VoxelGridMapping<ScalarType>& mapping, const ScalarType& max_distance) :
+                    _distance_field(Vector3s::Zero(), Vector3s::Ones(), mapping.getCellSize()),
+                    _cells(1, 1, 1),
+                    _max_distance(max_distance)
+                {
+                    Vector3s min_point, max_point;
+                    mapping.getBoundingBox(min_point, max_point);
+                    _distance_field = VoxelGrid<ScalarType, ScalarType, Layout>(min_point, max_point, mapping.getCellSize());
+                    _distance_field.setTransform(mapping.getTransform());
+                    _cells = Grid3D<CellData, Layout>(_distance_field.getXSize(), _distance_field.getYSize(),
+                                                      _distance_field.getZSize());
+                    initialize();
+                }
+
+                /**
+                 * Marks the given cells as occupied or free and updates the distance field accordingly.
+                 * Cells that are already in the requested state are ignored.
+                 * Throws a std::out_of_range if any of the given cells is out of bounds, in which case
+                 * the distance field is left unchanged.
+                 * @param occupied_cells - cells that became occupied
+                 * @param freed_cells - cells that became free
+                 * @return the number of cells whose distance (or closest obstacle) was modified
+                 */
+                size_t update(const std::vector<UnsignedIndex>& occupied_cells,
+                              const std::vector<UnsignedIndex>& freed_cells) {
+                    // validate all cells first, so that an invalid cell can not leave the field half updated
+                    for (auto& idx : occupied_cells) {
+                        if (not _cells.inBounds(idx)) {
+                            throw std::out_of_range("The provided index is out of range for this grid.");
+                        }
+                    }
+                    for (auto& idx : freed_cells) {
+                        if (not _cells.inBounds(idx)) {
+                            throw std::out_of_range("The provided index is out of range for this grid.");
+                        }
+                    }
+                    _touched_cells.clear();
+                    ++_update_stamp;
+                    if (_update_stamp == 0) {
+                        // the stamp wrapped around, reset all stamps to avoid false positives
+                        for (auto& cell : _cells) cell.touch_stamp = 0;
+                        _update_stamp = 1;
+                    }
+                    for (auto& idx : freed_cells) {
+                        removeObstacle(idx);
+                    }
+                    for (auto& idx : occupied_cells) {
+                        setObstacle(idx);
+                    }
+                    propagate();
+                    const ScalarType cell_size = _distance_field.getCellSize();
+                    for (auto& idx : _touched_cells) {
+                        const CellData& cell = _cells(idx);
+                        _distance_field(idx) = cell.obst_x < 0 ? _max_distance :
+                            std::min(_max_distance, cell_size * std::sqrt((ScalarType)cell.sq_dist));
+                    }
+                    return _touched_cells.size();
+                }
+
+                /**
+                 * Returns the number of cells modified by the last update.
+                 */
+                size_t getNumTouchedCells() const {
+                    return _touched_cells.size();
+                }
+
+                /**
+                 * Returns the cells modified by the last update.
+                 */
+                const std::vector<UnsignedIndex>& getTouchedCells() const {
+                    return _touched_cells;
+                }
+
+                /**
+                 * Returns the distance of the given cell to its closest occupied cell (capped at the maximal distance).
+                 */
+                ScalarType getDistance(const UnsignedIndex& idx) const {
+                    return _distance_field.at(idx);
+                }
+
+                /**
+                 * Returns the index of the occupied cell closest to the given cell.
+                 * @return false if there is no occupied cell within the maximal distance
+                 */
+                bool getClosestObstacle(const UnsignedIndex& idx, UnsignedIndex& obstacle_idx) const {
+                    const CellData& cell = _cells.at(idx);
+                    if (cell.obst_x < 0) return false;
+                    obstacle_idx.set(cell.obst_x, cell.obst_y, cell.obst_z);
+                    return true;
+                }
+
+                bool isOccupied(const UnsignedIndex& idx) const {
+                    return _cells.at(idx).occupied;
+                }
+
+                ScalarType getMaxDistance() const {
+                    return _max_distance;
+                }
+
+                /**
+                 * Returns a voxel grid storing the current distance of each cell.
+                 */
+                const VoxelGrid<ScalarType, ScalarType, Layout>& getDistanceField() const {
+                    return _distance_field;
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_DYNAMIC_DISTANCE_FIELD_H
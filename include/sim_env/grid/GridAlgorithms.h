@@ -0,0 +1,257 @@
+#ifndef SIM_ENV_GRID_GRID_ALGORITHMS_H
+#define SIM_ENV_GRID_GRID_ALGORITHMS_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Parallel cell-wise operations on Grid3D (and thus VoxelGrid).
+ * All operations split the grid into chunks of z-slices that are processed in parallel.
+ * For RowMajorLayout, a chunk of slices is contiguous in memory and is processed as one flat loop that the
+ * compiler can vectorize for arithmetic value types. For other layouts, cells are visited by index, so that
+ * padding cells of the layout are never touched.
+ * The passed operations are called concurrently and must hence be thread-safe.
+ */
+namespace sim_env {
+    namespace grid {
+        namespace algorithms_detail {
+            template<typename Layout>
+            struct IsContiguous {
+                static constexpr bool value = std::is_same<Layout, RowMajorLayout>::value;
+            };
+
+            template<typename ValueType1, typename Layout1, typename ValueType2, typename Layout2>
+            void checkSameShape(const Grid3D<ValueType1, Layout1>& a, const Grid3D<ValueType2, Layout2>& b) {
+                if (a.getXSize() != b.getXSize() or a.getYSize() != b.getYSize() or a.getZSize() != b.getZSize()) {
+                    throw std::invalid_argument("The grids must have the same number of cells in each dimension.");
+                }
+            }
+
+            // Number of independent accumulators used for arithmetic reductions over contiguous memory.
+            static const size_t REDUCTION_LANES = 8;
+
+            template<typename T, typename ValueType, typename BinaryOp>
+            T reduceRange(const ValueType* data, size_t begin, size_t end, const T& identity, BinaryOp& op,
+                          std::true_type /* arithmetic */) {
+                T lanes[REDUCTION_LANES];
+                for (size_t l = 0; l < REDUCTION_LANES; ++l) {
+                    lanes[l] = identity;
+                }
+                size_t i = begin;
+                for (; i + REDUCTION_LANES <= end; i += REDUCTION_LANES) {
+                    for (size_t l = 0; l < REDUCTION_LANES; ++l) {
+                        lanes[l] = op(lanes[l], data[i + l]);
+                    }
+                }
+                T result = identity;
+                for (size_t l = 0; l < REDUCTION_LANES; ++l) {
+                    result = op(result, lanes[l]);
+                }
+                for (; i < end; ++i) {
+                    result = op(result, data[i]);
+                }
+                return result;
+            }
+
+            template<typename T, typename ValueType, typename BinaryOp>
+            T reduceRange(const ValueType* data, size_t begin, size_t end, const T& identity, BinaryOp& op,
+                          std::false_type /* arithmetic */) {
+                T result = identity;
+                for (size_t i = begin; i < end; ++i) {
+                    result = op(result, data[i]);
+                }
+                return result;
+            }
+        }
+
+        /**
+         * Sets each cell of grid to op(value of the cell).
+         * @param grid - grid to transform in place
+         * @param op - unary operation ValueType -> ValueType
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueType, typename Layout, typename UnaryOp>
+        void transform(Grid3D<ValueType, Layout>& grid, UnaryOp op, unsigned int num_threads = 0) {
+            if (grid.getStorageSize() == 0) return;
+            const size_t x_size = grid.getXSize();
+            const size_t y_size = grid.getYSize();
+            const size_t xy_size = x_size * y_size;
+            utils::parallel::parallelFor(0, grid.getZSize(), [&](size_t z_begin, size_t z_end) {
+                if (algorithms_detail::IsContiguous<Layout>::value) {
+                    ValueType* data = &grid[0];
+                    for (size_t i = z_begin * xy_size; i < z_end * xy_size; ++i) {
+                        data[i] = op(data[i]);
+                    }
+                } else {
+                    for (size_t z = z_begin; z < z_end; ++z) {
+                        for (size_t y = 0; y < y_size; ++y) {
+                            for (size_t x = 0; x < x_size; ++x) {
+                                ValueType& value = grid(x, y, z);
+                                value = op(value);
+                            }
+                        }
+                    }
+                }
+            }, num_threads);
+        }
+
+        /**
+         * Sets each cell of output to op(value of the same cell in input).
+         * Throws std::invalid_argument if the grids differ in size.
+         * @param input - input grid
+         * @param output - output grid, may be the same as input
+         * @param op - unary operation InValueType -> OutValueType
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename InValueType, typename OutValueType, typename Layout, typename UnaryOp>
+        void transform(const Grid3D<InValueType, Layout>& input, Grid3D<OutValueType, Layout>& output, UnaryOp op,
+                       unsigned int num_threads = 0) {
+            algorithms_detail::checkSameShape(input, output);
+            if (input.getStorageSize() == 0) return;
+            const size_t x_size = input.getXSize();
+            const size_t y_size = input.getYSize();
+            const size_t xy_size = x_size * y_size;
+            utils::parallel::parallelFor(0, input.getZSize(), [&](size_t z_begin, size_t z_end) {
+                if (algorithms_detail::IsContiguous<Layout>::value) {
+                    const InValueType* in_data = &input[0];
+                    OutValueType* out_data = &output[0];
+                    for (size_t i = z_begin * xy_size; i < z_end * xy_size; ++i) {
+                        out_data[i] = op(in_data[i]);
+                    }
+                } else {
+                    for (size_t z = z_begin; z < z_end; ++z) {
+                        for (size_t y = 0; y < y_size; ++y) {
+                            for (size_t x = 0; x < x_size; ++x) {
+                                output(x, y, z) = op(input(x, y, z));
+                            }
+                        }
+                    }
+                }
+            }, num_threads);
+        }
+
+        /**
+         * Sets each cell of output to op(value of the cell in a, value of the cell in b).
+         * Throws std::invalid_argument if the grids differ in size.
+         * @param a - first input grid
+         * @param b - second input grid
+         * @param output - output grid, may be the same as a or b
+         * @param op - binary operation (ValueTypeA, ValueTypeB) -> OutValueType
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueTypeA, typename ValueTypeB, typename OutValueType, typename Layout, typename BinaryOp>
+        void transform2(const Grid3D<ValueTypeA, Layout>& a, const Grid3D<ValueTypeB, Layout>& b,
+                        Grid3D<OutValueType, Layout>& output, BinaryOp op, unsigned int num_threads = 0) {
+            algorithms_detail::checkSameShape(a, b);
+            algorithms_detail::checkSameShape(a, output);
+            if (a.getStorageSize() == 0) return;
+            const size_t x_size = a.getXSize();
+            const size_t y_size = a.getYSize();
+            const size_t xy_size = x_size * y_size;
+            utils::parallel::parallelFor(0, a.getZSize(), [&](size_t z_begin, size_t z_end) {
+                if (algorithms_detail::IsContiguous<Layout>::value) {
+                    const ValueTypeA* a_data = &a[0];
+                    const ValueTypeB* b_data = &b[0];
+                    OutValueType* out_data = &output[0];
+                    for (size_t i = z_begin * xy_size; i < z_end * xy_size; ++i) {
+                        out_data[i] = op(a_data[i], b_data[i]);
+                    }
+                } else {
+                    for (size_t z = z_begin; z < z_end; ++z) {
+                        for (size_t y = 0; y < y_size; ++y) {
+                            for (size_t x = 0; x < x_size; ++x) {
+                                output(x, y, z) = op(a(x, y, z), b(x, y, z));
+                            }
+                        }
+                    }
+                }
+            }, num_threads);
+        }
+
+        /**
+         * Reduces all cells of grid with the given operation, e.g. reduce(grid, 0.0f, std::plus<float>())
+         * computes the sum of all values.
+         * The operation must be associative and commutative, since cells are combined in an unspecified
+         * (but deterministic) order. Each z-slice is reduced separately and the per-slice results are
+         * combined in order of z.
+         * @param grid - grid to reduce
+         * @param identity - identity element of op, e.g. 0 for sums or the lowest value for max
+         * @param op - binary operation (T, ValueType) -> T and (T, T) -> T
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         * @return the reduction of all cells, identity for empty grids
+         */
+        template<typename ValueType, typename Layout, typename T, typename BinaryOp>
+        T reduce(const Grid3D<ValueType, Layout>& grid, const T& identity, BinaryOp op, unsigned int num_threads = 0) {
+            if (grid.getStorageSize() == 0) return identity;
+            const size_t x_size = grid.getXSize();
+            const size_t y_size = grid.getYSize();
+            const size_t xy_size = x_size * y_size;
+            std::vector<T> slice_results(grid.getZSize(), identity);
+            utils::parallel::parallelFor(0, grid.getZSize(), [&](size_t z_begin, size_t z_end) {
+                for (size_t z = z_begin; z < z_end; ++z) {
+                    if (algorithms_detail::IsContiguous<Layout>::value) {
+                        typedef std::integral_constant<bool, std::is_arithmetic<ValueType>::value and
+                                                             std::is_arithmetic<T>::value> is_arithmetic;
+                        slice_results[z] = algorithms_detail::reduceRange(&grid[0], z * xy_size, (z + 1) * xy_size,
+                                                                          identity, op, is_arithmetic());
+                    } else {
+                        T result = identity;
+                        for (size_t y = 0; y < y_size; ++y) {
+                            for (size_t x = 0; x < x_size; ++x) {
+                                result = op(result, grid(x, y, z));
+                            }
+                        }
+                        slice_results[z] = result;
+                    }
+                }
+            }, num_threads);
+            T result = identity;
+            for (auto& slice_result : slice_results) {
+                result = op(result, slice_result);
+            }
+            return result;
+        }
+
+        /**
+         * Returns the number of cells of grid for which pred(value of the cell) is true.
+         * @param grid - grid to count cells of
+         * @param pred - unary predicate on ValueType
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueType, typename Layout, typename UnaryPredicate>
+        size_t countIf(const Grid3D<ValueType, Layout>& grid, UnaryPredicate pred, unsigned int num_threads = 0) {
+            if (grid.getStorageSize() == 0) return 0;
+            const size_t x_size = grid.getXSize();
+            const size_t y_size = grid.getYSize();
+            const size_t xy_size = x_size * y_size;
+            std::vector<size_t> slice_counts(grid.getZSize(), 0);
+            utils::parallel::parallelFor(0, grid.getZSize(), [&](size_t z_begin, size_t z_end) {
+                for (size_t z = z_begin; z < z_end; ++z) {
+                    size_t count = 0;
+                    if (algorithms_detail::IsContiguous<Layout>::value) {
+                        const ValueType* data = &grid[0];
+                        for (size_t i = z * xy_size; i < (z + 1) * xy_size; ++i) {
+                            count += pred(data[i]) ? 1 : 0;
+                        }
+                    } else {
+                        for (size_t y = 0; y < y_size; ++y) {
+                            for (size_t x = 0; x < x_size; ++x) {
+                                count += pred(grid(x, y, z)) ? 1 : 0;
+                            }
+                        }
+                    }
+                    slice_counts[z] = count;
+                }
+            }, num_threads);
+            size_t count = 0;
+            for (auto& slice_count : slice_counts) {
+                count += slice_count;
+            }
+            return count;
+        }
+    }
+}
+#endif //SIM_ENV_GRID_GRID_ALGORITHMS_H
@@ -0,0 +1,286 @@
+#ifndef SIM_ENV_GRID_GRID_FILTERS_H
+#define SIM_ENV_GRID_GRID_FILTERS_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <cmath>
+#include <functional>
+#include <limits>
+#include <stdexcept>
+#include <type_traits>
+#include <vector>
+
+/*
+ * Separable filters on Grid3D (and thus VoxelGrid).
+ * All filters are applied as a sequence of one-dimensional passes along the x, y and z axis. Each pass
+ * uses a running-window algorithm, so that the cost per cell is independent of the filter radius.
+ * Windows are clipped at the boundary of the grid, i.e. cells outside of the grid are ignored.
+ * The passes are parallelized over slices of the grid.
+ */
+namespace sim_env {
+    namespace grid {
+        namespace filter_detail {
+            /**
+             * Applies line_fn(const ValueType* in, ValueType* out, size_t n, size_t radius) to every line along
+             * every axis with non-zero radius of the given row-major volume, one axis after the other.
+             */
+            template<typename ValueType, typename LineFunction>
+            void applyAlongAxes(std::vector<ValueType>& volume, const size_t sizes[3], const size_t radii[3],
+                                const LineFunction& line_fn, unsigned int num_threads) {
+                const size_t x_size = sizes[0];
+                const size_t y_size = sizes[1];
+                const size_t z_size = sizes[2];
+                const size_t xy_size = x_size * y_size;
+                const size_t max_size = std::max(x_size, std::max(y_size, z_size));
+                ValueType* data = volume.data();
+                auto run_pass = [&](size_t slice_begin, size_t slice_end, size_t num_lines, size_t n, size_t radius,
+                                    size_t stride, size_t slice_stride, size_t line_stride) {
+                    std::vector<ValueType> in(max_size);
+                    std::vector<ValueType> out(max_size);
+                    for (size_t slice = slice_begin; slice < slice_end; ++slice) {
+                        for (size_t line = 0; line < num_lines; ++line) {
+                            ValueType* line_data = data + slice * slice_stride + line * line_stride;
+                            for (size_t i = 0; i < n; ++i) {
+                                in[i] = line_data[i * stride];
+                            }
+                            line_fn(in.data(), out.data(), n, radius);
+                            for (size_t i = 0; i < n; ++i) {
+                                line_data[i * stride] = out[i];
+                            }
+                        }
+                    }
+                };
+                if (radii[0] > 0) {
+                    utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                        run_pass(begin, end, y_size, x_size, radii[0], 1, xy_size, x_size);
+                    }, num_threads);
+                }
+                if (radii[1] > 0) {
+                    utils::parallel::parallelFor(0, z_size, [&](size_t begin, size_t end) {
+                        run_pass(begin, end, x_size, y_size, radii[1], x_size, xy_size, 1);
+                    }, num_threads);
+                }
+                if (radii[2] > 0) {
+                    utils::parallel::parallelFor(0, y_size, [&](size_t begin, size_t end) {
+                        run_pass(begin, end, x_size, z_size, radii[2], xy_size, x_size, 1);
+                    }, num_threads);
+                }
+            }
+
+            template<typename ValueType, typename Layout>
+            void copyToVolume(const Grid3D<ValueType, Layout>& grid, std::vector<ValueType>& volume) {
+                const size_t x_size = grid.getXSize();
+                const size_t y_size = grid.getYSize();
+                volume.resize(x_size * y_size * grid.getZSize());
+                size_t i = 0;
+                for (size_t z = 0; z < grid.getZSize(); ++z) {
+                    for (size_t y = 0; y < y_size; ++y) {
+                        for (size_t x = 0; x < x_size; ++x) {
+                            volume[i++] = grid(x, y, z);
+                        }
+                    }
+                }
+            }
+
+            template<typename ValueType, typename Layout>
+            void copyFromVolume(const std::vector<ValueType>& volume, Grid3D<ValueType, Layout>& grid) {
+                const size_t x_size = grid.getXSize();
+                const size_t y_size = grid.getYSize();
+                size_t i = 0;
+                for (size_t z = 0; z < grid.getZSize(); ++z) {
+                    for (size_t y = 0; y < y_size; ++y) {
+                        for (size_t x = 0; x < x_size; ++x) {
+                            grid(x, y, z) = volume[i++];
+                        }
+                    }
+                }
+            }
+
+            template<typename ValueType, typename Layout>
+            void checkFilterArguments(const Grid3D<ValueType, Layout>& input, const Grid3D<ValueType, Layout>& output) {
+                static_assert(std::is_arithmetic<ValueType>::value, "Filters require an arithmetic value type.");
+                if (input.getXSize() != output.getXSize() or input.getYSize() != output.getYSize()
+                    or input.getZSize() != output.getZSize()) {
+                    throw std::invalid_argument("The output grid must have the same size as the input grid.");
+                }
+            }
+
+            /**
+             * Mean over the window [i - radius, i + radius] clipped to the line, computed with a running sum.
+             */
+            template<typename ValueType>
+            void boxLine(const ValueType* in, ValueType* out, size_t n, size_t radius) {
+                typedef typename std::conditional<std::is_floating_point<ValueType>::value,
+                                                  ValueType, double>::type SumType;
+                SumType sum = 0;
+                // window of out[0] is [0, radius]
+                size_t window_end = std::min(n, radius + 1);
+                for (size_t i = 0; i < window_end; ++i) {
+                    sum += in[i];
+                }
+                for (size_t i = 0; i < n; ++i) {
+                    size_t window_begin = i > radius ? i - radius : 0;
+                    out[i] = (ValueType)(sum / (SumType)(window_end - window_begin));
+                    // move window to i + 1
+                    if (window_end < n) {
+                        sum += in[window_end++];
+                    }
+                    if (i >= radius) {
+                        sum -= in[i - radius];
+                    }
+                }
+            }
+
+            /**
+             * Maximum (Compare = std::greater) or minimum (Compare = std::less) over the window
+             * [i - radius, i + radius] clipped to the line, using the algorithm by van Herk and Gil and Werman
+             * with three comparisons per element regardless of the radius.
+             */
+            template<typename ValueType, typename Compare>
+            void extremumLine(const ValueType* in, ValueType* out, size_t n, size_t radius,
+                              const ValueType& neutral, std::vector<ValueType>& prefix,
+                              std::vector<ValueType>& suffix) {
+                Compare better;
+                const size_t width = 2 * radius + 1;
+                // line padded by radius neutral elements on each side
+                const size_t padded_size = n + 2 * radius;
+                prefix.resize(padded_size);
+                suffix.resize(padded_size);
+                auto padded = [&](size_t k) -> const ValueType& {
+                    return k < radius or k >= radius + n ? neutral : in[k - radius];
+                };
+                for (size_t block = 0; block < padded_size; block += width) {
+                    size_t block_end = std::min(block + width, padded_size);
+                    prefix[block] = padded(block);
+                    for (size_t k = block + 1; k < block_end; ++k) {
+                        const ValueType& value = padded(k);
+                        prefix[k] = better(value, prefix[k - 1]) ? value : prefix[k - 1];
+                    }
+                    suffix[block_end - 1] = padded(block_end - 1);
+                    for (size_t k = block_end - 1; k > block; --k) {
+                        const ValueType& value = padded(k - 1);
+                        suffix[k - 1] = better(value, suffix[k]) ? value : suffix[k];
+                    }
+                }
+                // the window of out[i] is [i, i + width - 1] in padded coordinates
+                for (size_t i = 0; i < n; ++i) {
+                    const ValueType& a = suffix[i];
+                    const ValueType& b = prefix[i + width - 1];
+                    out[i] = better(b, a) ? b : a;
+                }
+            }
+
+            template<typename ValueType, typename Compare, typename Layout>
+            void extremumFilter(const Grid3D<ValueType, Layout>& input, Grid3D<ValueType, Layout>& output,
+                                size_t radius_x, size_t radius_y, size_t radius_z, const ValueType& neutral,
+                                unsigned int num_threads) {
+                checkFilterArguments(input, output);
+                std::vector<ValueType> volume;
+                copyToVolume(input, volume);
+                const size_t sizes[3] = {input.getXSize(), input.getYSize(), input.getZSize()};
+                const size_t radii[3] = {radius_x, radius_y, radius_z};
+                applyAlongAxes(volume, sizes, radii,
+                    [&neutral](const ValueType* in, ValueType* out, size_t n, size_t radius) {
+                        // scratch buffers are reused across the lines processed by one thread
+                        thread_local std::vector<ValueType> prefix, suffix;
+                        extremumLine<ValueType, Compare>(in, out, n, radius, neutral, prefix, suffix);
+                    }, num_threads);
+                copyFromVolume(volume, output);
+            }
+        }
+
+        /**
+         * Sets each cell of output to the mean of the cells of input within the box of
+         * (2 * radius_x + 1) x (2 * radius_y + 1) x (2 * radius_z + 1) cells centered at the cell.
+         * Cells outside of the grid are not included in the mean.
+         * @param input - input grid
+         * @param output - output grid of the same size as input, may be input itself
+         * @param radius_x, radius_y, radius_z - radii of the box in cells
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueType, typename Layout>
+        void boxFilter(const Grid3D<ValueType, Layout>& input, Grid3D<ValueType, Layout>& output,
+                       size_t radius_x, size_t radius_y, size_t radius_z, unsigned int num_threads = 0) {
+            filter_detail::checkFilterArguments(input, output);
+            std::vector<ValueType> volume;
+            filter_detail::copyToVolume(input, volume);
+            const size_t sizes[3] = {input.getXSize(), input.getYSize(), input.getZSize()};
+            const size_t radii[3] = {radius_x, radius_y, radius_z};
+            filter_detail::applyAlongAxes(volume, sizes, radii, &filter_detail::boxLine<ValueType>, num_threads);
+            filter_detail::copyFromVolume(volume, output);
+        }
+
+        /**
+         * Smoothes input with an approximate Gaussian kernel with standard deviation sigma (in cells).
+         * The Gaussian is approximated by three successive box filters with suitably chosen radii
+         * (see P. Kovesi, "Fast Almost-Gaussian Filtering", 2010), so the cost is independent of sigma.
+         * @param input - input grid
+         * @param output - output grid of the same size as input, may be input itself
+         * @param sigma - standard deviation in cells
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueType, typename Layout>
+        void gaussianFilter(const Grid3D<ValueType, Layout>& input, Grid3D<ValueType, Layout>& output,
+                            double sigma, unsigned int num_threads = 0) {
+            filter_detail::checkFilterArguments(input, output);
+            if (sigma < 0.0) {
+                throw std::invalid_argument("The standard deviation must not be negative.");
+            }
+            const int num_passes = 3;
+            // widths of the box filters: the first num_lower passes use lower_width, the others lower_width + 2
+            double ideal_width = std::sqrt(12.0 * sigma * sigma / num_passes + 1.0);
+            int lower_width = (int)std::floor(ideal_width);
+            if (lower_width % 2 == 0) --lower_width;
+            int num_lower = (int)std::round((12.0 * sigma * sigma - num_passes * lower_width * lower_width
+                                             - 4.0 * num_passes * lower_width - 3.0 * num_passes)
+                                            / (-4.0 * lower_width - 4.0));
+            std::vector<ValueType> volume;
+            filter_detail::copyToVolume(input, volume);
+            const size_t sizes[3] = {input.getXSize(), input.getYSize(), input.getZSize()};
+            for (int pass = 0; pass < num_passes; ++pass) {
+                int width = pass < num_lower ? lower_width : lower_width + 2;
+                size_t radius = (size_t)(width / 2);
+                const size_t radii[3] = {radius, radius, radius};
+                filter_detail::applyAlongAxes(volume, sizes, radii, &filter_detail::boxLine<ValueType>, num_threads);
+            }
+            filter_detail::copyFromVolume(volume, output);
+        }
+
+        /**
+         * Dilation: sets each cell of output to the maximum of the cells of input within the box of
+         * (2 * radius_x + 1) x (2 * radius_y + 1) x (2 * radius_z + 1) cells centered at the cell.
+         * The cost per cell is independent of the radii.
+         * @param input - input grid
+         * @param output - output grid of the same size as input, may be input itself
+         * @param radius_x, radius_y, radius_z - radii of the box in cells
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ValueType, typename Layout>
+        void maxFilter(const Grid3D<ValueType, Layout>& input, Grid3D<ValueType, Layout>& output,
+                       size_t radius_x, size_t radius_y, size_t radius_z, unsigned int num_threads = 0) {
+            const ValueType neutral = std::numeric_limits<ValueType>::has_infinity ?
+                                      -std::numeric_limits<ValueType>::infinity() :
+                                      std::numeric_limits<ValueType>::lowest();
+            filter_detail::extremumFilter<ValueType, std::greater<ValueType> >(input, output, radius_x, radius_y,
+                                                                               radius_z, neutral, num_threads);
+        }
+
+        /**
+         * Erosion: sets each cell of output to the minimum of the cells of input within the box of
+         * (2 * radius_x + 1) x (2 * radius_y + 1) x (2 * radius_z + 1) cells centered at the cell.
+         * The cost per cell is independent of the radii.
+         * See maxFilter for the parameters.
+         */
+        template<typename ValueType, typename Layout>
+        void minFilter(const Grid3D<ValueType, Layout>& input, Grid3D<ValueType, Layout>& output,
+                       size_t radius_x, size_t radius_y, size_t radius_z, unsigned int num_threads = 0) {
+            const ValueType neutral = std::numeric_limits<ValueType>::has_infinity ?
+                                      std::numeric_limits<ValueType>::infinity() :
+                                      std::numeric_limits<ValueType>::max();
+            filter_detail::extremumFilter<ValueType, std::less<ValueType> >(input, output, radius_x, radius_y,
+                                                                            radius_z, neutral, num_threads);
+        }
+    }
+}
+#endif //SIM_ENV_GRID_GRID_FILTERS_H
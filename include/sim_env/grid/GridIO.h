@@ -0,0 +1,503 @@
+#ifndef SIM_ENV_GRID_GRID_IO_H
+#define SIM_ENV_GRID_GRID_IO_H
+
+#include <sim_env/Grid.h>
+#include <cstdint>
+#include <cstring>
+#include <limits>
+#include <memory>
+#include <stdexcept>
+#include <string>
+#include <type_traits>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        /**
+         * Binary on-disk format for Grid3D and VoxelGrid.
+         * A file consists of a FileHeader followed by the raw cell data in the storage order of the grid's
+         * layout, starting at the (cache line aligned) offset data_offset. Since the data is stored exactly as
+         * it is in memory, a file can be memory mapped and accessed in place (see MappedVoxelGrid).
+         * Files are only portable between machines with the same byte order.
+         */
+        namespace grid_io {
+            static const uint32_t FORMAT_VERSION = 1;
+            static const uint32_t BYTE_ORDER_MARK = 0x01020304;
+            static const uint64_t DATA_ALIGNMENT = 64;
+
+            enum TypeTag : uint32_t {
+                OPAQUE = 0, // any other trivially copyable type, only the size is checked
+                INT8 = 1, UINT8 = 2, INT16 = 3, UINT16 = 4, INT32 = 5, UINT32 = 6, INT64 = 7, UINT64 = 8,
+                FLOAT32 = 9, FLOAT64 = 10
+            };
+
+            enum LayoutTag : uint32_t {
+                ROW_MAJOR = 1, TILED = 2, MORTON = 3,
+                RLE_BRICKS = 4 // run-length encoded bricks, see CompressedVoxelGrid
+            };
+
+            struct FileHeader {
+                char magic[8];
+                uint32_t version;
+                uint32_t byte_order;
+                uint32_t value_type; // TypeTag of the cell values
+                uint32_t value_size; // sizeof the cell values
+                uint32_t scalar_type; // TypeTag of the ScalarType of a VoxelGrid, OPAQUE for a plain Grid3D
+                uint32_t layout_type; // LayoutTag
+                uint64_t layout_parameter; // tile size for tiled layouts, 0 otherwise
+                uint64_t x_size;
+                uint64_t y_size;
+                uint64_t z_size;
+                uint64_t storage_size; // number of stored values, may exceed the number of cells
+                uint64_t data_offset; // offset of the cell data from the beginning of the file in bytes
+                double cell_size;
+                double min_point[3];
+                double max_point[3];
+                double transform[16]; // column-major 4x4 matrix of the grid's transform
+            };
+
+            template<typename T>
+            struct TypeTagOf {
+                static constexpr uint32_t value =
+                    std::is_floating_point<T>::value ?
+                        (sizeof(T) == 4 ? FLOAT32 : (sizeof(T) == 8 ? FLOAT64 : OPAQUE)) :
+                    std::is_integral<T>::value ?
+                        (sizeof(T) == 1 ? (std::is_signed<T>::value ? INT8 : UINT8) :
+                         sizeof(T) == 2 ? (std::is_signed<T>::value ? INT16 : UINT16) :
+                         sizeof(T) == 4 ? (std::is_signed<T>::value ? INT32 : UINT32) :
+                         sizeof(T) == 8 ? (std::is_signed<T>::value ? INT64 : UINT64) : OPAQUE) :
+                    OPAQUE;
+            };
+
+            // Maps a layout policy to its LayoutTag and parameter. Layouts without specialization can not be stored.
+            template<typename Layout>
+            struct LayoutTagOf;
+
+            template<>
+            struct LayoutTagOf<RowMajorLayout> {
+                static constexpr uint32_t type = ROW_MAJOR;
+                static constexpr uint64_t parameter = 0;
+            };
+
+            template<size_t TileSize>
+            struct LayoutTagOf<TiledLayout<TileSize> > {
+                static constexpr uint32_t type = TILED;
+                static constexpr uint64_t parameter = TileSize;
+            };
+
+            template<>
+            struct LayoutTagOf<MortonLayout> {
+                static constexpr uint32_t type = MORTON;
+                static constexpr uint64_t parameter = 0;
+            };
+
+            /**
+             * Fills in magic, version, byte order and data offset of the given header.
+             */
+            void initHeader(FileHeader& header);
+
+            /**
+             * Writes header and data to the file at path. Throws std::runtime_error on failure.
+             */
+            void writeFile(const std::string& path, const FileHeader& header, const void* data, size_t num_bytes);
+
+            struct DataBlock {
+                const void* data;
+                size_t num_bytes;
+            };
+
+            /**
+             * Rounds the given file offset up to the next multiple of DATA_ALIGNMENT.
+             */
+            inline uint64_t alignOffset(uint64_t offset) {
+                return (offset + DATA_ALIGNMENT - 1) / DATA_ALIGNMENT * DATA_ALIGNMENT;
+            }
+
+            /**
+             * Writes the header followed by multiple data blocks to the file at path. The first block starts at
+             * header.data_offset, each following block at the aligned offset after the end of its predecessor.
+             * Throws std::runtime_error on failure.
+             */
+            void writeFile(const std::string& path, const FileHeader& header, const std::vector<DataBlock>& blocks);
+
+            /**
+             * Checks that the given header, read from the file at path, belongs to a valid grid file of this
+             * version and byte order. Throws std::runtime_error otherwise.
+             */
+            void checkHeader(const FileHeader& header, const std::string& path);
+
+            /**
+             * Reads and checks the header of the file at path. Throws std::runtime_error on failure.
+             */
+            FileHeader readHeader(const std::string& path);
+
+            /**
+             * Reads num_bytes of cell data of a file with the given header into data.
+             * Throws std::runtime_error on failure.
+             */
+            void readData(const std::string& path, const FileHeader& header, void* data, size_t num_bytes);
+
+            /**
+             * Read-only memory mapping of a whole file. The mapping is shared with other processes mapping
+             * the same file, i.e. pages are loaded lazily on first access and only once into physical memory.
+             */
+            class MappedFile {
+                public:
+                    /**
+                     * Maps the file at path. Throws std::runtime_error on failure.
+                     */
+                    explicit MappedFile(const std::string& path);
+                    MappedFile(const MappedFile&) = delete;
+                    MappedFile& operator=(const MappedFile&) = delete;
+                    ~MappedFile();
+                    const char* getData() const;
+                    size_t getSize() const;
+                private:
+                    void* _data;
+                    size_t _size;
+            };
+
+            /**
+             * Checks that the given header describes a grid with values of type ValueType in layout Layout and
+             * that a file of file_size bytes can hold its data. Throws std::runtime_error otherwise.
+             */
+            template<typename ValueType, typename Layout>
+            void checkCompatibility(const FileHeader& header, const std::string& path, uint64_t file_size = 0) {
+                static_assert(std::is_trivially_copyable<ValueType>::value,
+                              "Only grids of trivially copyable types can be read from binary.");
+                if (header.value_type != TypeTagOf<ValueType>::value or header.value_size != sizeof(ValueType)) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The value type stored in " + path +
+                                             " does not match the requested value type.");
+                }
+                if (header.layout_type != LayoutTagOf<Layout>::type or
+                    header.layout_parameter != LayoutTagOf<Layout>::parameter) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The memory layout stored in " + path +
+                                             " does not match the requested layout.");
+                }
+                if (header.y_size > 0 and header.z_size > 0 and
+                    header.x_size > std::numeric_limits<uint64_t>::max() / header.y_size / header.z_size) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The grid size in " + path + " is too large.");
+                }
+                Layout layout;
+                size_t storage_size;
+                try {
+                    storage_size = layout.reset(header.x_size, header.y_size, header.z_size);
+                } catch (const std::invalid_argument& e) {
+                    // e.g. a grid size that is not supported by the layout
+                    throw std::runtime_error("[sim_env::grid::grid_io] The grid size in " + path +
+                                             " is not supported by the requested layout: " + e.what());
+                }
+                if (storage_size != header.storage_size) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The storage size in " + path +
+                                             " is inconsistent with the grid size.");
+                }
+                // written without products or sums, which could overflow for corrupted headers
+                if (file_size > 0 and (header.data_offset > file_size or
+                    header.storage_size > (file_size - header.data_offset) / sizeof(ValueType))) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The file " + path + " is truncated.");
+                }
+            }
+
+            template<typename ValueType, typename Layout>
+            void fillHeader(const Grid3D<ValueType, Layout>& grid, FileHeader& header) {
+                static_assert(not std::is_same<ValueType, bool>::value, "Grids of bool can not be stored in binary.");
+                static_assert(std::is_trivially_copyable<ValueType>::value,
+                              "Only grids of trivially copyable types can be stored in binary.");
+                initHeader(header);
+                header.value_type = TypeTagOf<ValueType>::value;
+                header.value_size = sizeof(ValueType);
+                header.scalar_type = OPAQUE;
+                header.layout_type = LayoutTagOf<Layout>::type;
+                header.layout_parameter = LayoutTagOf<Layout>::parameter;
+                header.x_size = grid.getXSize();
+                header.y_size = grid.getYSize();
+                header.z_size = grid.getZSize();
+                header.storage_size = grid.getStorageSize();
+            }
+
+            template<typename ScalarType>
+            void fillMappingHeader(const VoxelGridMapping<ScalarType>& mapping, FileHeader& header) {
+                static_assert(std::is_floating_point<ScalarType>::value, "ScalarType must be a floating point type.");
+                header.scalar_type = TypeTagOf<ScalarType>::value;
+                header.cell_size = mapping.getCellSize();
+                typename VoxelGridMapping<ScalarType>::Vector3s min_point, max_point;
+                mapping.getBoundingBox(min_point, max_point);
+                Eigen::Matrix4d matrix = mapping.getTransform().matrix().template cast<double>();
+                for (unsigned int i = 0; i < 3; ++i) {
+                    header.min_point[i] = min_point[i];
+                    header.max_point[i] = max_point[i];
+                }
+                for (unsigned int i = 0; i < 16; ++i) {
+                    header.transform[i] = matrix.data()[i];
+                }
+            }
+
+            /**
+             * Creates the mapping described by the given header. Throws std::runtime_error if the file
+             * does not contain a voxel grid with the given ScalarType.
+             */
+            template<typename ScalarType>
+            VoxelGridMapping<ScalarType> createMapping(const FileHeader& header, const std::string& path) {
+                typedef typename VoxelGridMapping<ScalarType>::Vector3s Vector3s;
+                if (header.scalar_type != TypeTagOf<ScalarType>::value) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The file " + path +
+                                             " does not contain a voxel grid with the requested scalar type.");
+                }
+                VoxelGridMapping<ScalarType> mapping(
+                    Vector3s(header.min_point[0], header.min_point[1], header.min_point[2]),
+                    Vector3s(header.max_point[0], header.max_point[1], header.max_point[2]),
+                    ScalarType(header.cell_size));
+                Eigen::Matrix4d matrix;
+                for (unsigned int i = 0; i < 16; ++i) {
+                    matrix.data()[i] = header.transform[i];
+                }
+                typename VoxelGridMapping<ScalarType>::Transform tf;
+                tf.matrix() = matrix.cast<ScalarType>();
+                mapping.setTransform(tf);
+                auto& num_cells = mapping.getNumCells();
+                if (num_cells[0] != header.x_size or num_cells[1] != header.y_size or num_cells[2] != header.z_size) {
+                    throw std::runtime_error("[sim_env::grid::grid_io] The bounding box stored in " + path +
+                                             " is inconsistent with the grid size.");
+                }
+                return mapping;
+            }
+        }
+
+        /**
+         * Stores the given grid in the binary format described above.
+         * Throws std::runtime_error on failure.
+         */
+        template<typename ValueType, typename Layout>
+        void saveBinary(const Grid3D<ValueType, Layout>& grid, const std::string& path) {
+            grid_io::FileHeader header;
+            grid_io::fillHeader(grid, header);
+            grid_io::writeFile(path, header, grid.getStorageSize() > 0 ? &grid[0] : nullptr,
+                               grid.getStorageSize() * sizeof(ValueType));
+        }
+
+        /**
+         * Stores the given voxel grid, including bounding box, cell size and transform,
+         * in the binary format described above. Throws std::runtime_error on failure.
+         */
+        template<typename ScalarType, typename ValueType, typename Layout>
+        void saveBinary(const VoxelGrid<ScalarType, ValueType, Layout>& grid, const std::string& path) {
+            grid_io::FileHeader header;
+            grid_io::fillHeader(grid, header);
+            grid_io::fillMappingHeader(grid.getMapping(), header);
+            grid_io::writeFile(path, header, grid.getStorageSize() > 0 ? &grid[0] : nullptr,
+                               grid.getStorageSize() * sizeof(ValueType));
+        }
+
+        /**
+         * Loads the grid stored at path into grid. The file may contain a Grid3D or a VoxelGrid, but the
+         * value type and layout must match. Throws std::runtime_error on failure.
+         */
+        template<typename ValueType, typename Layout>
+        void loadBinary(const std::string& path, Grid3D<ValueType, Layout>& grid) {
+            grid_io::FileHeader header = grid_io::readHeader(path);
+            grid_io::checkCompatibility<ValueType, Layout>(header, path);
+            grid = Grid3D<ValueType, Layout>(header.x_size, header.y_size, header.z_size);
+            grid_io::readData(path, header, grid.getStorageSize() > 0 ? &grid[0] : nullptr,
+                              grid.getStorageSize() * sizeof(ValueType));
+        }
+
+        /**
+         * Loads the voxel grid stored at path into grid. Throws std::runtime_error on failure.
+         */
+        template<typename ScalarType, typename ValueType, typename Layout>
+        void loadBinary(const std::string& path, VoxelGrid<ScalarType, ValueType, Layout>& grid) {
+            typedef typename VoxelGrid<ScalarType, ValueType, Layout>::Vector3s Vector3s;
+            grid_io::FileHeader header = grid_io::readHeader(path);
+            grid_io::checkCompatibility<ValueType, Layout>(header, path);
+            VoxelGridMapping<ScalarType> mapping = grid_io::createMapping<ScalarType>(header, path);
+            Vector3s min_point, max_point;
+            mapping.getBoundingBox(min_point, max_point);
+            grid = VoxelGrid<ScalarType, ValueType, Layout>(min_point, max_point, mapping.getCellSize());
+            grid.setTransform(mapping.getTransform());
+            grid_io::readData(path, header, grid.getStorageSize() > 0 ? &grid[0] : nullptr,
+                              grid.getStorageSize() * sizeof(ValueType));
+        }
+
+        /**
+         * Read-only Grid3D that accesses the cell data of a binary grid file in place through a memory mapping.
+         * Opening is independent of the size of the grid, and the pages of the file are shared between all
+         * processes that map it. Copies of a MappedGrid3D share the same mapping.
+         */
+        template<typename ValueType, typename Layout = RowMajorLayout>
+        class MappedGrid3D {
+            public:
+                static_assert(std::is_trivially_copyable<ValueType>::value,
+                              "Only grids of trivially copyable types can be mapped.");
+                /**
+                 * Maps the grid stored at path. Throws std::runtime_error if the file can not be mapped or does
+                 * not contain a grid with matching value type and layout.
+                 */
+                explicit MappedGrid3D(const std::string& path) :
+                    _file(std::make_shared<grid_io::MappedFile>(path))
+                {
+                    if (_file->getSize() < sizeof(grid_io::FileHeader)) {
+                        throw std::runtime_error("[sim_env::grid::MappedGrid3D] The file " + path +
+                                                 " is not a grid file.");
+                    }
+                    std::memcpy(&_header, _file->getData(), sizeof(grid_io::FileHeader));
+                    grid_io::checkHeader(_header, path);
+                    grid_io::checkCompatibility<ValueType, Layout>(_header, path, _file->getSize());
+                    _layout.reset(_header.x_size, _header.y_size, _header.z_size);
+                    _values = reinterpret_cast<const ValueType*>(_file->getData() + _header.data_offset);
+                }
+
+                MappedGrid3D(const MappedGrid3D& other) = default;
+                ~MappedGrid3D() = default;
+                MappedGrid3D& operator=(const MappedGrid3D& other) = default;
+
+                inline size_t getXSize() const {
+                    return _header.x_size;
+                }
+
+                inline size_t getYSize() const {
+                    return _header.y_size;
+                }
+
+                inline size_t getZSize() const {
+                    return _header.z_size;
+                }
+
+                inline bool inBounds(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return ix < _header.x_size && iy < _header.y_size && iz < _header.z_size;
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return idx.ix >= 0 and idx.iy >= 0 and idx.iz >= 0 and inBounds(idx.toUnsignedIndex());
+                }
+
+                inline bool inBounds(const UnsignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                inline size_t getFlatIndex(const size_t& x, const size_t& y, const size_t& z) const {
+                    return _layout.getIndex(x, y, z);
+                }
+
+                inline size_t getFlatIndex(const UnsignedIndex& idx) const {
+                    return _layout.getIndex(idx.ix, idx.iy, idx.iz);
+                }
+
+                inline size_t getStorageSize() const {
+                    return _header.storage_size;
+                }
+
+                const ValueType& operator[](const size_t& flat_index) const {
+                    return _values[flat_index];
+                }
+
+                const ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return _values[getFlatIndex(ix, iy, iz)];
+                }
+
+                const ValueType& operator()(const UnsignedIndex& idx) const {
+                    return operator()(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return _values[getFlatIndex(ix, iy, iz)];
+                }
+
+                const ValueType& at(const UnsignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const SignedIndex& idx) const {
+                    if (not inBounds(idx)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return operator()(idx.toUnsignedIndex());
+                }
+
+                UnsignedIndexGenerator getIndexGenerator() const {
+                    return UnsignedIndexGenerator(_header.x_size, _header.y_size, _header.z_size);
+                }
+
+                const ValueType* begin() const noexcept {
+                    return _values;
+                }
+
+                const ValueType* end() const noexcept {
+                    return _values + _header.storage_size;
+                }
+
+            protected:
+                grid_io::FileHeader _header;
+            private:
+                std::shared_ptr<grid_io::MappedFile> _file;
+                Layout _layout;
+                const ValueType* _values;
+        };
+
+        /**
+         * Read-only VoxelGrid backed by a memory mapped binary grid file, see MappedGrid3D.
+         */
+        template<typename ScalarType, typename ValueType, typename Layout = RowMajorLayout>
+        class MappedVoxelGrid : public MappedGrid3D<ValueType, Layout> {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+
+                /**
+                 * Maps the voxel grid stored at path. Throws std::runtime_error if the file can not be mapped
+                 * or does not contain a voxel grid with matching scalar type, value type and layout.
+                 */
+                explicit MappedVoxelGrid(const std::string& path) :
+                    MappedGrid3D<ValueType, Layout>(path),
+                    _mapping(grid_io::createMapping<ScalarType>(this->_header, path))
+                {
+                }
+
+                MappedVoxelGrid(const MappedVoxelGrid& other) = default;
+                ~MappedVoxelGrid() = default;
+                MappedVoxelGrid& operator=(const MappedVoxelGrid& other) = default;
+
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    return _mapping.getCellIdx(position);
+                }
+
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    return _mapping.getValidCellIdx(position, is_valid);
+                }
+
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
+                }
+
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                ScalarType getCellSize() const {
+                    return _mapping.getCellSize();
+                }
+
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    _mapping.getBoundingBox(min_point, max_point);
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
+                    return _mapping.getTransform();
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
+                    return _mapping.getInvTransform();
+                }
+
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+
+            private:
+                VoxelGridMapping<ScalarType> _mapping;
+        };
+    }
+}
+#endif //SIM_ENV_GRID_GRID_IO_H
@@ -0,0 +1,351 @@
+#ifndef SIM_ENV_GRID_GRID_SEARCH_H
+#define SIM_ENV_GRID_GRID_SEARCH_H
+
+#include <sim_env/Grid.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        /**
+         * A GridSearch runs A* and Dijkstra searches on the cells of a Grid3D, where each cell is connected
+         * to its 6-, 18- or 26-neighborhood (see GridNeighborhood).
+         * The per-cell search data is allocated once for the whole grid and is reused across queries:
+         * instead of clearing it, each query increments an epoch counter and data with an older epoch is
+         * treated as unvisited. The open list is an indexed binary heap that supports decrease-key, so each
+         * cell is in the open list at most once.
+         * By default, moving from a cell to a neighbor costs the value of the neighbor times the
+         * Euclidean length of the move (in cells). Cells with negative or infinite value are not traversable.
+         * Custom cost functions and heuristics can be passed to the query functions.
+         * The grid is referenced, not copied, so it must outlive the search. Its values may change between
+         * queries, its size must not.
+         * A GridSearch is not thread-safe; use one instance per thread.
+         */
+        template<typename ValueType, typename Layout = RowMajorLayout>
+        class GridSearch {
+            public:
+                /*
+                 * Creates a search on the given grid.
+                 * @param grid - the grid to search on
+                 * @param connectivity - either 6, 18 or 26
+                 */
+                GridSearch(const Grid3D<ValueType, Layout>& grid, unsigned int connectivity = 26) :
+                    _grid(grid),
+                    _neighborhood(grid, connectivity),
+                    _connectivity(connectivity),
+                    _nodes(grid.getStorageSize()),
+                    _epoch(0),
+                    _num_expansions(0),
+                    _min_cell_cost(0.0)
+                {
+                    updateMinCellCost();
+                }
+
+                /*
+                 * Searches a path from start to goal using A* with the default cost function and a heuristic
+                 * based on the minimal cell cost (see updateMinCellCost()).
+                 * @param start - start cell
+                 * @param goal - goal cell
+                 * @param path - output, sequence of cells from start to goal (both inclusive) if a path exists
+                 * @return whether a path exists
+                 */
+                bool findPath(const UnsignedIndex& start, const UnsignedIndex& goal, std::vector<UnsignedIndex>& path) {
+                    const double min_cost = _min_cell_cost;
+                    const unsigned int connectivity = _connectivity;
+                    return findPath(start, goal, path, DefaultCost(),
+                        [&goal, min_cost, connectivity](const UnsignedIndex& idx) {
+                            return min_cost * GridSearch::getDistance(idx, goal, connectivity);
+                        });
+                }
+
+                /*
+                 * Searches a path from start to goal using A*.
+                 * @param start - start cell
+                 * @param goal - goal cell
+                 * @param path - output, sequence of cells from start to goal (both inclusive) if a path exists
+                 * @param cost - function double(const UnsignedIndex& from, const UnsignedIndex& to,
+                 *              const ValueType& to_value, double move_length) returning the non-negative cost
+                 *              of moving between the neighboring cells from and to, or infinity if not possible.
+                 *              move_length is the Euclidean length of the move in cells.
+                 * @param heuristic - function double(const UnsignedIndex& idx) returning a consistent estimate
+                 *              of the cost from idx to goal, e.g. 0 for Dijkstra.
+                 * @return whether a path exists
+                 */
+                template<typename CostFunction, typename Heuristic>
+                bool findPath(const UnsignedIndex& start, const UnsignedIndex& goal, std::vector<UnsignedIndex>& path,
+                              CostFunction cost, Heuristic heuristic) {
+                    checkIndex(start);
+                    checkIndex(goal);
+                    run(start, _grid.getFlatIndex(goal), cost, heuristic, std::numeric_limits<double>::infinity());
+                    return getPath(goal, path);
+                }
+
+                /*
+                 * Computes the costs of the cheapest paths from start to all cells with cost at most max_cost
+                 * (Dijkstra) using the default cost function. Query the results with getCost(..) and getPath(..).
+                 */
+                void computeCosts(const UnsignedIndex& start, double max_cost = std::numeric_limits<double>::infinity()) {
+                    computeCosts(start, DefaultCost(), max_cost);
+                }
+
+                /*
+                 * Computes the costs of the cheapest paths from start to all cells with cost at most max_cost
+                 * (Dijkstra) using the given cost function (see findPath(..)).
+                 */
+                template<typename CostFunction>
+                void computeCosts(const UnsignedIndex& start, CostFunction cost,
+                                  double max_cost = std::numeric_limits<double>::infinity()) {
+                    checkIndex(start);
+                    run(start, NO_GOAL, cost, [](const UnsignedIndex&) { return 0.0; }, max_cost);
+                }
+
+                /*
+                 * Returns the cost of the cheapest path from the start of the last query to idx, or infinity
+                 * if the last query did not reach idx. After findPath(..), only the cost of the goal and
+                 * of expanded cells is guaranteed to be optimal.
+                 */
+                double getCost(const UnsignedIndex& idx) const {
+                    const NodeData& node = _nodes[_grid.getFlatIndex(idx)];
+                    return node.epoch == _epoch ? node.g : std::numeric_limits<double>::infinity();
+                }
+
+                /*
+                 * Retrieves the path from the start of the last query to target.
+                 * @return false if the last query did not reach target
+                 */
+                bool getPath(const UnsignedIndex& target, std::vector<UnsignedIndex>& path) const {
+                    path.clear();
+                    const NodeData* node = &_nodes[_grid.getFlatIndex(target)];
+                    if (node->epoch != _epoch) {
+                        return false;
+                    }
+                    UnsignedIndex idx = target;
+                    path.push_back(idx);
+                    while (node->parent != NO_PARENT) {
+                        const SignedIndex& offset = _neighborhood.getOffset(node->parent);
+                        idx = UnsignedIndex(idx.ix - offset.ix, idx.iy - offset.iy, idx.iz - offset.iz);
+                        path.push_back(idx);
+                        node = &_nodes[_grid.getFlatIndex(idx)];
+                    }
+                    std::reverse(path.begin(), path.end());
+                    return true;
+                }
+
+                /*
+                 * Returns the number of cells expanded by the last query.
+                 */
+                size_t getNumExpansions() const {
+                    return _num_expansions;
+                }
+
+                /*
+                 * Recomputes the minimal value of all traversable cells, which scales the default heuristic.
+                 * Call this after lowering values of the grid, otherwise the default heuristic may overestimate.
+                 */
+                void updateMinCellCost() {
+                    double min_cost = std::numeric_limits<double>::infinity();
+                    UnsignedIndexGenerator gen = _grid.getIndexGenerator();
+                    while (gen.hasNext()) {
+                        double value = (double)_grid(gen.next());
+                        if (value >= 0.0 and value < min_cost) {
+                            min_cost = value;
+                        }
+                    }
+                    _min_cell_cost = std::isfinite(min_cost) ? min_cost : 0.0;
+                }
+
+                /*
+                 * Returns a lower bound on the length (in cells) of any path between the cells a and b
+                 * with the given connectivity, i.e. the Manhattan distance for 6-connectivity, the 3D octile
+                 * distance for 26-connectivity and the Euclidean distance for 18-connectivity.
+                 */
+                static double getDistance(const UnsignedIndex& a, const UnsignedIndex& b, unsigned int connectivity) {
+                    double d[3] = {std::abs((double)a.ix - (double)b.ix),
+                                   std::abs((double)a.iy - (double)b.iy),
+                                   std::abs((double)a.iz - (double)b.iz)};
+                    if (connectivity == 6) {
+                        return d[0] + d[1] + d[2];
+                    }
+                    if (connectivity == 18) {
+                        return std::sqrt(d[0] * d[0] + d[1] * d[1] + d[2] * d[2]);
+                    }
+                    std::sort(d, d + 3);
+                    static const double SQRT2 = std::sqrt(2.0);
+                    static const double SQRT3 = std::sqrt(3.0);
+                    return (SQRT3 - SQRT2) * d[0] + (SQRT2 - 1.0) * d[1] + d[2];
+                }
+
+            private:
+                static const uint8_t NO_PARENT = 0xff;
+                static const uint32_t CLOSED = 0xffffffff;
+                static const size_t NO_GOAL = std::numeric_limits<size_t>::max();
+
+                // Search data of a cell. It is only valid if epoch is the epoch of the current query.
+                struct NodeData {
+                    double g;
+                    uint32_t epoch;
+                    uint32_t heap_position; // position in the open list, CLOSED if expanded
+                    uint8_t parent; // index of the neighborhood offset from the parent to this cell
+                    NodeData() : g(0.0), epoch(0), heap_position(CLOSED), parent(NO_PARENT) {}
+                };
+
+                struct HeapEntry {
+                    double f;
+                    double g;
+                    size_t flat_index;
+                    uint32_t ix;
+                    uint32_t iy;
+                    uint32_t iz;
+                };
+
+                struct DefaultCost {
+                    double operator()(const UnsignedIndex&, const UnsignedIndex&, const ValueType& value,
+                                      double move_length) const {
+                        return value >= 0 ? (double)value * move_length : std::numeric_limits<double>::infinity();
+                    }
+                };
+
+                const Grid3D<ValueType, Layout>& _grid;
+                GridNeighborhood<Layout> _neighborhood;
+                unsigned int _connectivity;
+                std::vector<NodeData> _nodes;
+                std::vector<HeapEntry> _heap;
+                uint32_t _epoch;
+                size_t _num_expansions;
+                double _min_cell_cost;
+
+                void checkIndex(const UnsignedIndex& idx) const {
+                    if (not _grid.inBounds(idx)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    if (idx.ix > std::numeric_limits<uint32_t>::max() or idx.iy > std::numeric_limits<uint32_t>::max()
+                        or idx.iz > std::numeric_limits<uint32_t>::max()) {
+                        throw std::out_of_range("GridSearch supports at most 2^32 cells per dimension.");
+                    }
+                }
+
+                void startQuery() {
+                    ++_epoch;
+                    if (_epoch == 0) {
+                        // the epoch counter wrapped around, so old data could appear valid
+                        std::fill(_nodes.begin(), _nodes.end(), NodeData());
+                        _epoch = 1;
+                    }
+                    _heap.clear();
+                    _num_expansions = 0;
+                }
+
+                // Orders by f and breaks ties in favor of larger g, i.e. of cells closer to the goal.
+                static inline bool isBefore(const HeapEntry& a, const HeapEntry& b) {
+                    return a.f < b.f or (a.f == b.f and a.g > b.g);
+                }
+
+                inline void setHeapEntry(size_t position, const HeapEntry& entry) {
+                    _heap[position] = entry;
+                    _nodes[entry.flat_index].heap_position = (uint32_t)position;
+                }
+
+                void siftUp(size_t position) {
+                    HeapEntry entry = _heap[position];
+                    while (position > 0) {
+                        size_t parent = (position - 1) / 2;
+                        if (not isBefore(entry, _heap[parent])) break;
+                        setHeapEntry(position, _heap[parent]);
+                        position = parent;
+                    }
+                    setHeapEntry(position, entry);
+                }
+
+                void siftDown(size_t position) {
+                    HeapEntry entry = _heap[position];
+                    const size_t size = _heap.size();
+                    while (true) {
+                        size_t child = 2 * position + 1;
+                        if (child >= size) break;
+                        if (child + 1 < size and isBefore(_heap[child + 1], _heap[child])) ++child;
+                        if (not isBefore(_heap[child], entry)) break;
+                        setHeapEntry(position, _heap[child]);
+                        position = child;
+                    }
+                    setHeapEntry(position, entry);
+                }
+
+                HeapEntry pop() {
+                    HeapEntry top = _heap.front();
+                    _nodes[top.flat_index].heap_position = CLOSED;
+                    if (_heap.size() > 1) {
+                        _heap.front() = _heap.back();
+                        _heap.pop_back();
+                        siftDown(0);
+                    } else {
+                        _heap.pop_back();
+                    }
+                    return top;
+                }
+
+                template<typename CostFunction, typename Heuristic>
+                void run(const UnsignedIndex& start, size_t goal_flat_index, CostFunction& cost, const Heuristic& heuristic,
+                         double max_cost) {
+                    startQuery();
+                    size_t start_flat_index = _grid.getFlatIndex(start);
+                    NodeData& start_node = _nodes[start_flat_index];
+                    start_node.g = 0.0;
+                    start_node.epoch = _epoch;
+                    start_node.parent = NO_PARENT;
+                    _heap.push_back(HeapEntry{heuristic(start), 0.0, start_flat_index,
+                                              (uint32_t)start.ix, (uint32_t)start.iy, (uint32_t)start.iz});
+                    siftUp(0);
+                    while (not _heap.empty()) {
+                        HeapEntry current = pop();
+                        const double current_g = _nodes[current.flat_index].g;
+                        if (current_g > max_cost) {
+                            // the node is reached, but should not count as such
+                            _nodes[current.flat_index].epoch = _epoch - 1;
+                            break;
+                        }
+                        ++_num_expansions;
+                        if (current.flat_index == goal_flat_index) break;
+                        UnsignedIndex current_idx(current.ix, current.iy, current.iz);
+                        _neighborhood.forEach(current_idx,
+                            [&](size_t i, const UnsignedIndex& neighbor_idx, size_t neighbor_flat_index) {
+                                NodeData& neighbor = _nodes[neighbor_flat_index];
+                                const bool visited = neighbor.epoch == _epoch;
+                                if (visited and neighbor.heap_position == CLOSED) return;
+                                double edge_cost = cost(current_idx, neighbor_idx, _grid[neighbor_flat_index],
+                                                        _neighborhood.getOffsetLength(i));
+                                // also rejects NaN
+                                if (not (edge_cost < std::numeric_limits<double>::infinity())) return;
+                                double g = current_g + edge_cost;
+                                if (visited and g >= neighbor.g) return;
+                                neighbor.g = g;
+                                neighbor.parent = (uint8_t)i;
+                                double f = g + heuristic(neighbor_idx);
+                                if (visited) {
+                                    _heap[neighbor.heap_position].f = f;
+                                    _heap[neighbor.heap_position].g = g;
+                                    siftUp(neighbor.heap_position);
+                                } else {
+                                    neighbor.epoch = _epoch;
+                                    _heap.push_back(HeapEntry{f, g, neighbor_flat_index, (uint32_t)neighbor_idx.ix,
+                                                              (uint32_t)neighbor_idx.iy, (uint32_t)neighbor_idx.iz});
+                                    siftUp(_heap.size() - 1);
+                                }
+                            });
+                    }
+                    if (max_cost < std::numeric_limits<double>::infinity()) {
+                        // cells remaining in the open list have costs above max_cost or are not final
+                        for (auto& entry : _heap) {
+                            if (_nodes[entry.flat_index].g > max_cost) {
+                                _nodes[entry.flat_index].epoch = _epoch - 1;
+                            }
+                        }
+                    }
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_GRID_SEARCH_H
@@ -0,0 +1,101 @@
+#ifndef SIM_ENV_GRID_OCCUPANCY_GRID_H
+#define SIM_ENV_GRID_OCCUPANCY_GRID_H
+
+#include <sim_env/Grid.h>
+#include <cstdint>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * An OccupancyGrid fuses range measurements into occupancy probabilities. Each cell of a
+         * VoxelGrid<float, float> stores the log-odds l = log(p / (1 - p)) of being occupied, starting at 0 (p = 0.5).
+         * A measurement is a ray from a sensor origin to an endpoint: the cell containing the endpoint is updated
+         * as hit, all other cells along the ray as free.
+         * Rays are inserted in batches. Within a batch, each cell is updated at most once, i.e. rays sharing a
+         * cell only count once, and a hit takes precedence over free space.
+         * All cells whose value changed are recorded in a dirty set, so that consumers can update incrementally.
+         */
+        class OccupancyGrid {
+        public:
+            EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+            struct Parameters {
+                // log-odds added to a cell containing an endpoint, log(0.7 / 0.3)
+                float hit_log_odds;
+                // log-odds added to a cell traversed by a ray, log(0.4 / 0.6)
+                float miss_log_odds;
+                // bounds to which log-odds are clamped, corresponding to p = 0.12 and p = 0.97
+                float min_log_odds;
+                float max_log_odds;
+                // cells with log-odds above this threshold are considered occupied
+                float occupied_log_odds;
+                // rays are truncated at this distance and do not produce a hit, negative for no limit
+                float max_range;
+                Parameters() :
+                    hit_log_odds(0.85f), miss_log_odds(-0.4f), min_log_odds(-2.0f), max_log_odds(3.5f),
+                    occupied_log_odds(0.0f), max_range(-1.0f) {}
+            };
+
+            OccupancyGrid(const Eigen::Vector3f& min_point, const Eigen::Vector3f& max_point, float cell_size,
+                          const Parameters& params = Parameters());
+
+            /**
+             * Inserts a batch of rays. The rays are traversed in parallel.
+             * @param origins - sensor origins in world frame, one per column. If origins has a single column,
+             *                  it is used for all rays, e.g. for a point cloud of a single sensor.
+             * @param endpoints - measured points in world frame, one per column
+             * @param num_threads - maximal number of threads to use, 0 for all available
+             */
+            void insertRays(const Eigen::Matrix3Xf& origins, const Eigen::Matrix3Xf& endpoints,
+                            unsigned int num_threads = 0);
+
+            /**
+             * Inserts a single ray, see insertRays.
+             */
+            void insertRay(const Eigen::Vector3f& origin, const Eigen::Vector3f& endpoint);
+
+            float getLogOdds(const UnsignedIndex& idx) const;
+            float getProbability(const UnsignedIndex& idx) const;
+            bool isOccupied(const UnsignedIndex& idx) const;
+
+            /**
+             * Returns the underlying grid of log-odds. The transform of the grid can be set using setTransform.
+             */
+            const VoxelGrid<float, float>& getGrid() const;
+            void setTransform(const Eigen::Affine3f& tf);
+            const Parameters& getParameters() const;
+
+            /**
+             * Returns the cells that changed since the last call of clearDirtyCells. Each cell is contained once.
+             */
+            const std::vector<UnsignedIndex>& getDirtyCells() const;
+
+            /**
+             * Moves the dirty cells into cells and clears the dirty set.
+             */
+            void takeDirtyCells(std::vector<UnsignedIndex>& cells);
+            void clearDirtyCells();
+
+            /**
+             * Resets all cells to log-odds 0. All cells that change are marked as dirty.
+             */
+            void clear();
+
+        private:
+            VoxelGrid<float, float> _grid;
+            Parameters _params;
+            // per cell: 2 * batch + 1 if hit in this batch, 2 * batch if free in this batch, smaller values otherwise
+            Grid3D<uint32_t> _stamps;
+            uint32_t _batch;
+            Grid3D<uint8_t> _dirty_flags;
+            std::vector<UnsignedIndex> _dirty_cells;
+
+            void nextBatch();
+            void updateCells(const std::vector<size_t>& touched_cells, size_t begin, size_t end,
+                             std::vector<UnsignedIndex>& dirty_cells);
+            void markDirty(size_t flat_index, std::vector<UnsignedIndex>& dirty_cells);
+        };
+    }
+}
+#endif //SIM_ENV_GRID_OCCUPANCY_GRID_H
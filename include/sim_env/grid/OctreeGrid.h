@@ -0,0 +1,533 @@
+#ifndef SIM_ENV_GRID_OCTREE_GRID_H
+#define SIM_ENV_GRID_OCTREE_GRID_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/grid/RayCasting.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdint>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * An OctreeGrid provides the same spatial relations and value access as a VoxelGrid, but stores
+         * homogeneous regions as single octree leaves. The octree is stored pointerless as a linear octree:
+         * each leaf is identified by the Morton code of its min corner cell and its level (a leaf of level l
+         * covers 2^l x 2^l x 2^l cells), and leaves are kept sorted by Morton code in flat arrays.
+         * Looking up a cell is a binary search over the leaf codes. Leaves that lie completely outside of
+         * the grid are not stored. Leaves are always merged maximally, i.e. no 8 sibling leaves share a value.
+         * NOTE: Since cells do not have their own storage, values can only be read by reference. Use set(..)
+         * to change values. Requires ValueType to be comparable with operator==.
+         */
+        template<typename ScalarType, typename ValueType>
+        class OctreeGrid {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+            private:
+                // aligned_allocator also avoids the bit-packed std::vector<bool> specialization
+                typedef std::vector<ValueType, Eigen::aligned_allocator<ValueType> > ValueVector;
+                static const size_t MAX_DEPTH = 21;
+
+                VoxelGridMapping<ScalarType> _mapping;
+                size_t _x_size;
+                size_t _y_size;
+                size_t _z_size;
+                size_t _depth;
+                std::vector<uint64_t> _codes;
+                std::vector<uint8_t> _levels;
+                ValueVector _values;
+
+                static inline uint64_t getCode(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    return MortonLayout::spreadBits(ix) | (MortonLayout::spreadBits(iy) << 1) |
+                           (MortonLayout::spreadBits(iz) << 2);
+                }
+
+                static inline uint64_t compactBits(uint64_t v) {
+                    v &= 0x1249249249249249ull;
+                    v = (v | v >> 2) & 0x10c30c30c30c30c3ull;
+                    v = (v | v >> 4) & 0x100f00f00f00f00full;
+                    v = (v | v >> 8) & 0x1f0000ff0000ffull;
+                    v = (v | v >> 16) & 0x1f00000000ffffull;
+                    v = (v | v >> 32) & 0x1fffff;
+                    return v;
+                }
+
+                static inline UnsignedIndex getCorner(const uint64_t& code) {
+                    return UnsignedIndex(compactBits(code), compactBits(code >> 1), compactBits(code >> 2));
+                }
+
+                // number of Morton codes covered by a node of the given level
+                static inline uint64_t getCodeSpan(const size_t& level) {
+                    return uint64_t(1) << (3 * level);
+                }
+
+                inline bool intersectsGrid(const UnsignedIndex& corner) const {
+                    return corner.ix < _x_size and corner.iy < _y_size and corner.iz < _z_size;
+                }
+
+                void computeSizes() {
+                    auto& num_cells = _mapping.getNumCells();
+                    _x_size = num_cells[0];
+                    _y_size = num_cells[1];
+                    _z_size = num_cells[2];
+                    const size_t max_size = std::max(std::max(_x_size, _y_size), _z_size);
+                    _depth = 0;
+                    while ((size_t(1) << _depth) < max_size) {
+                        ++_depth;
+                    }
+                    if (_depth > MAX_DEPTH) {
+                        throw std::invalid_argument("OctreeGrid supports at most 2^21 cells per dimension.");
+                    }
+                }
+
+                void pushLeaf(const uint64_t& code, const size_t& level, const ValueType& value) {
+                    _codes.push_back(code);
+                    _levels.push_back((uint8_t)level);
+                    _values.push_back(value);
+                }
+
+                // Returns the position of the leaf that contains the cell with the given code.
+                // The cell must be within bounds.
+                inline size_t findLeaf(const uint64_t& code) const {
+                    return std::upper_bound(_codes.begin(), _codes.end(), code) - _codes.begin() - 1;
+                }
+
+                // Returns the range [begin, end) of leaves within the node with the given code and level.
+                inline void getLeafRange(const uint64_t& code, const size_t& level, size_t& begin, size_t& end) const {
+                    begin = std::lower_bound(_codes.begin(), _codes.end(), code) - _codes.begin();
+                    end = std::lower_bound(_codes.begin() + begin, _codes.end(), code + getCodeSpan(level)) - _codes.begin();
+                }
+
+                enum class NodeState {
+                    Outside, Uniform, Mixed
+                };
+
+                // Appends the leaves of the node with the given code and level built from grid and returns its state.
+                template<typename Layout>
+                NodeState buildNode(const VoxelGrid<ScalarType, ValueType, Layout>& grid, const uint64_t& code,
+                                    const size_t& level) {
+                    const UnsignedIndex corner = getCorner(code);
+                    if (not intersectsGrid(corner)) {
+                        return NodeState::Outside;
+                    }
+                    if (level == 0) {
+                        pushLeaf(code, 0, grid(corner.ix, corner.iy, corner.iz));
+                        return NodeState::Uniform;
+                    }
+                    const size_t first_leaf = _codes.size();
+                    bool uniform = true;
+                    for (uint64_t child = 0; child < 8; ++child) {
+                        NodeState state = buildNode(grid, code + child * getCodeSpan(level - 1), level - 1);
+                        uniform = uniform and state != NodeState::Mixed and
+                                  (state == NodeState::Outside or _values.back() == _values[first_leaf]);
+                    }
+                    if (not uniform) {
+                        return NodeState::Mixed;
+                    }
+                    // all children are single leaves with the same value
+                    ValueType value = _values[first_leaf];
+                    _codes.resize(first_leaf);
+                    _levels.resize(first_leaf);
+                    _values.resize(first_leaf);
+                    pushLeaf(code, level, value);
+                    return NodeState::Uniform;
+                }
+
+                // Appends the leaves resulting from splitting the node with the given code and level, such that
+                // the cell with code cell_code is a leaf of level 0. Children outside of the grid are dropped.
+                void splitNode(const uint64_t& code, const size_t& level, const uint64_t& cell_code,
+                               const ValueType& value, std::vector<uint64_t>& codes, std::vector<uint8_t>& levels,
+                               ValueVector& values) const {
+                    if (level == 0) {
+                        codes.push_back(code);
+                        levels.push_back(0);
+                        values.push_back(value);
+                        return;
+                    }
+                    const uint64_t child_span = getCodeSpan(level - 1);
+                    const uint64_t cell_child = (cell_code - code) / child_span;
+                    for (uint64_t child = 0; child < 8; ++child) {
+                        const uint64_t child_code = code + child * child_span;
+                        if (child == cell_child) {
+                            splitNode(child_code, level - 1, cell_code, value, codes, levels, values);
+                        } else if (intersectsGrid(getCorner(child_code))) {
+                            codes.push_back(child_code);
+                            levels.push_back((uint8_t)(level - 1));
+                            values.push_back(value);
+                        }
+                    }
+                }
+
+                // Merges the ancestors of the leaf containing cell_code as long as all their leaves share a value.
+                void mergeUpwards(const uint64_t& cell_code, const ValueType& value) {
+                    for (size_t level = 1; level <= _depth; ++level) {
+                        const uint64_t node_code = cell_code & ~(getCodeSpan(level) - 1);
+                        size_t begin, end;
+                        getLeafRange(node_code, level, begin, end);
+                        for (size_t i = begin; i < end; ++i) {
+                            if (not (_values[i] == value)) {
+                                return;
+                            }
+                        }
+                        _codes.erase(_codes.begin() + begin + 1, _codes.begin() + end);
+                        _levels.erase(_levels.begin() + begin + 1, _levels.begin() + end);
+                        _values.erase(_values.begin() + begin + 1, _values.begin() + end);
+                        _codes[begin] = node_code;
+                        _levels[begin] = (uint8_t)level;
+                    }
+                }
+
+                // Calls fn(corner, size, value) for each leaf within the given node that intersects the box
+                // [min_idx, max_idx]. Stops and returns false as soon as fn returns false.
+                template<typename Function>
+                bool visitBox(const uint64_t& code, const size_t& level, const UnsignedIndex& corner,
+                              const UnsignedIndex& min_idx, const UnsignedIndex& max_idx, Function& fn) const {
+                    size_t begin, end;
+                    getLeafRange(code, level, begin, end);
+                    if (begin == end) {
+                        return true;
+                    }
+                    if (_levels[begin] == level) {
+                        return fn(corner, size_t(1) << level, _values[begin]);
+                    }
+                    const size_t half = size_t(1) << (level - 1);
+                    for (uint64_t child = 0; child < 8; ++child) {
+                        UnsignedIndex child_corner(corner.ix + ((child & 1) ? half : 0),
+                                                   corner.iy + ((child & 2) ? half : 0),
+                                                   corner.iz + ((child & 4) ? half : 0));
+                        if (child_corner.ix > max_idx.ix or child_corner.ix + half <= min_idx.ix or
+                            child_corner.iy > max_idx.iy or child_corner.iy + half <= min_idx.iy or
+                            child_corner.iz > max_idx.iz or child_corner.iz + half <= min_idx.iz) {
+                            continue;
+                        }
+                        if (not visitBox(code + child * getCodeSpan(level - 1), level - 1, child_corner,
+                                         min_idx, max_idx, fn)) {
+                            return false;
+                        }
+                    }
+                    return true;
+                }
+
+                void checkBox(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx) const {
+                    if (not inBounds(min_idx) or not inBounds(max_idx) or min_idx.ix > max_idx.ix or
+                        min_idx.iy > max_idx.iy or min_idx.iz > max_idx.iz) {
+                        throw std::out_of_range("The provided cell range is invalid for this grid.");
+                    }
+                }
+
+            public:
+                OctreeGrid(const Vector3s& min_point, const Vector3s& max_point,
+                           const ScalarType& cell_size, ValueType default_value=ValueType()) :
+                    _mapping(min_point, max_point, cell_size)
+                {
+                    computeSizes();
+                    pushLeaf(0, _depth, default_value);
+                }
+
+                /*
+                 * Creates an octree with the same mapping and values as the given voxel grid.
+                 */
+                template<typename Layout>
+                explicit OctreeGrid(const VoxelGrid<ScalarType, ValueType, Layout>& grid) :
+                    _mapping(grid.getMapping())
+                {
+                    computeSizes();
+                    buildNode(grid, 0, _depth);
+                }
+
+                OctreeGrid(const OctreeGrid& other) = default;
+                ~OctreeGrid() = default;
+                OctreeGrid& operator=(const OctreeGrid& other) = default;
+
+                inline size_t getXSize() const {
+                    return _x_size;
+                }
+
+                inline size_t getYSize() const {
+                    return _y_size;
+                }
+
+                inline size_t getZSize() const {
+                    return _z_size;
+                }
+
+                inline bool inBounds(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return ix < _x_size && iy < _y_size && iz < _z_size;
+                }
+
+                inline bool inBounds(const long& ix, const long& iy, const long& iz) const {
+                    return ix >= 0 and iy >= 0 and iz >= 0 and ix < _x_size and iy < _y_size and iz < _z_size;
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                inline bool inBounds(const UnsignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return _values[findLeaf(getCode(ix, iy, iz))];
+                }
+
+                const ValueType& operator()(const UnsignedIndex& idx) const {
+                    return operator()(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return operator()(ix, iy, iz);
+                }
+
+                const ValueType& at(const long& ix, const long& iy, const long& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return operator()((size_t)ix, (size_t)iy, (size_t)iz);
+                }
+
+                const ValueType& at(const UnsignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const SignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                /*
+                 * Sets the value of the given cell. The leaf containing the cell is split if needed and
+                 * leaves are merged again if the cell's siblings share the new value.
+                 * Note that splitting and merging shift the leaf arrays, so bulk updates should rather
+                 * be done on a VoxelGrid that is then converted to an octree.
+                 */
+                void set(const size_t& ix, const size_t& iy, const size_t& iz, const ValueType& value) {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    const uint64_t cell_code = getCode(ix, iy, iz);
+                    const size_t leaf = findLeaf(cell_code);
+                    if (_values[leaf] == value) {
+                        return;
+                    }
+                    if (_levels[leaf] == 0) {
+                        _values[leaf] = value;
+                    } else {
+                        std::vector<uint64_t> codes;
+                        std::vector<uint8_t> levels;
+                        ValueVector values;
+                        splitNode(_codes[leaf], _levels[leaf], cell_code, _values[leaf], codes, levels, values);
+                        values[std::lower_bound(codes.begin(), codes.end(), cell_code) - codes.begin()] = value;
+                        _codes.erase(_codes.begin() + leaf);
+                        _levels.erase(_levels.begin() + leaf);
+                        _values.erase(_values.begin() + leaf);
+                        _codes.insert(_codes.begin() + leaf, codes.begin(), codes.end());
+                        _levels.insert(_levels.begin() + leaf, levels.begin(), levels.end());
+                        _values.insert(_values.begin() + leaf, values.begin(), values.end());
+                    }
+                    mergeUpwards(cell_code, value);
+                }
+
+                void set(const UnsignedIndex& idx, const ValueType& value) {
+                    set(idx.ix, idx.iy, idx.iz, value);
+                }
+
+                /*
+                 * Returns the level of the leaf containing the given valid cell, i.e. the leaf spans
+                 * 2^level cells in each dimension.
+                 */
+                size_t getLeafLevel(const UnsignedIndex& idx) const {
+                    return _levels[findLeaf(getCode(idx.ix, idx.iy, idx.iz))];
+                }
+
+                /*
+                 * Returns the number of levels below the root, i.e. the root spans 2^depth cells in each dimension.
+                 */
+                size_t getDepth() const {
+                    return _depth;
+                }
+
+                size_t getNumLeaves() const {
+                    return _codes.size();
+                }
+
+                /*
+                 * Returns the number of bytes occupied by the leaf arrays.
+                 */
+                size_t getAllocatedMemory() const {
+                    return _codes.size() * (sizeof(uint64_t) + sizeof(uint8_t) + sizeof(ValueType));
+                }
+
+                /*
+                 * Calls fn(const UnsignedIndex& corner, size_t size, const ValueType& value) for each leaf that
+                 * intersects the box of cells [min_idx, max_idx] (inclusive). corner is the min corner cell of
+                 * the leaf and size the number of cells it spans in each dimension, i.e. the leaf may exceed the
+                 * box. Leaves are visited in Morton order and subtrees outside of the box are skipped.
+                 */
+                template<typename Function>
+                void forEachLeafInBox(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx, Function fn) const {
+                    checkBox(min_idx, max_idx);
+                    auto visitor = [&fn](const UnsignedIndex& corner, size_t size, const ValueType& value) {
+                        fn(corner, size, value);
+                        return true;
+                    };
+                    visitBox(0, _depth, UnsignedIndex(0, 0, 0), min_idx, max_idx, visitor);
+                }
+
+                /*
+                 * Returns whether any cell within the box of cells [min_idx, max_idx] (inclusive) has a value
+                 * for which pred(value) is true. Each leaf is tested once and the traversal stops at the first hit.
+                 */
+                template<typename Predicate>
+                bool anyInBox(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx, Predicate pred) const {
+                    checkBox(min_idx, max_idx);
+                    auto visitor = [&pred](const UnsignedIndex&, size_t, const ValueType& value) {
+                        return not pred(value);
+                    };
+                    return not visitBox(0, _depth, UnsignedIndex(0, 0, 0), min_idx, max_idx, visitor);
+                }
+
+                /*
+                 * Casts a ray through the grid and returns the first cell for which is_hit(value) is true.
+                 * The ray skips whole leaves, i.e. large homogeneous regions are crossed in a single step.
+                 * @param origin - origin of the ray in world frame
+                 * @param direction - direction of the ray in world frame, does not need to be normalized
+                 * @param max_distance - maximal distance from origin to search for a hit
+                 * @param is_hit - unary predicate on ValueType
+                 * @param hit_idx - output, the cell through which the ray enters the hit leaf
+                 * @param hit_distance - output, distance from origin at which the ray enters hit_idx
+                 * @return whether a hit was found within max_distance
+                 */
+                template<typename Predicate>
+                bool castRay(const Vector3s& origin, const Vector3s& direction, const ScalarType& max_distance,
+                             Predicate is_hit, UnsignedIndex& hit_idx, ScalarType& hit_distance) const {
+                    // ray in cell coordinates; the parameter t remains the distance in world frame
+                    Vector3s start, dir;
+                    ScalarType t_begin, t_end;
+                    if (not ray_casting::clipRay(_mapping, origin, direction, max_distance, start, dir, t_begin, t_end)) {
+                        return false;
+                    }
+                    const size_t sizes[3] = {_x_size, _y_size, _z_size};
+                    size_t cell[3];
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        ScalarType coord = std::floor(start[d] + t_begin * dir[d]);
+                        cell[d] = (size_t)std::min(std::max(coord, ScalarType(0)), ScalarType(sizes[d] - 1));
+                    }
+                    ScalarType t = t_begin;
+                    while (true) {
+                        const size_t leaf = findLeaf(getCode(cell[0], cell[1], cell[2]));
+                        if (is_hit(_values[leaf])) {
+                            hit_idx = UnsignedIndex(cell[0], cell[1], cell[2]);
+                            hit_distance = t;
+                            return true;
+                        }
+                        // compute where the ray leaves the leaf
+                        const size_t leaf_size = size_t(1) << _levels[leaf];
+                        size_t leaf_min[3];
+                        ScalarType t_axis[3];
+                        ScalarType t_exit = std::numeric_limits<ScalarType>::max();
+                        for (unsigned int d = 0; d < 3; ++d) {
+                            leaf_min[d] = cell[d] & ~(leaf_size - 1);
+                            if (dir[d] == ScalarType(0)) {
+                                t_axis[d] = std::numeric_limits<ScalarType>::max();
+                                continue;
+                            }
+                            ScalarType boundary = dir[d] > 0 ? ScalarType(leaf_min[d] + leaf_size) : ScalarType(leaf_min[d]);
+                            t_axis[d] = (boundary - start[d]) / dir[d];
+                            t_exit = std::min(t_exit, t_axis[d]);
+                        }
+                        if (t_exit >= t_end) {
+                            return false;
+                        }
+                        t = std::max(t, t_exit);
+                        for (unsigned int d = 0; d < 3; ++d) {
+                            if (t_axis[d] == t_exit) {
+                                // step across the boundary of the leaf
+                                if (dir[d] > 0) {
+                                    cell[d] = leaf_min[d] + leaf_size;
+                                    if (cell[d] >= sizes[d]) return false;
+                                } else {
+                                    if (leaf_min[d] == 0) return false;
+                                    cell[d] = leaf_min[d] - 1;
+                                }
+                            } else {
+                                // stay within the leaf's extent despite rounding errors
+                                ScalarType coord = std::floor(start[d] + t * dir[d]);
+                                coord = std::max(coord, ScalarType(leaf_min[d]));
+                                coord = std::min(coord, ScalarType(std::min(leaf_min[d] + leaf_size, sizes[d]) - 1));
+                                cell[d] = (size_t)coord;
+                            }
+                        }
+                    }
+                }
+
+                UnsignedIndexGenerator getIndexGenerator() const {
+                    return UnsignedIndexGenerator(_x_size, _y_size, _z_size);
+                }
+
+                UnsignedBoxIndexGenerator getNeighborIndexGenerator(const UnsignedIndex& idx,
+                                                                    const size_t& dx,
+                                                                    const size_t& dy,
+                                                                    const size_t& dz) const {
+                    return UnsignedBoxIndexGenerator(_x_size, _y_size, _z_size, idx, dx, dy, dz);
+                }
+
+                /*
+                * Returns the index of the voxel in which the specified position in world frame lies.
+                * Note that the returned index may be out of bounds, if the position is out of bounds.
+                * You can check this by calling inBounds(idx). Alternatively, use getValidCellIdx(..)
+                */
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    return _mapping.getCellIdx(position);
+                }
+
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    return _mapping.getValidCellIdx(position, is_valid);
+                }
+
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
+                }
+
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                ScalarType getCellSize() const {
+                    return _mapping.getCellSize();
+                }
+
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    _mapping.getBoundingBox(min_point, max_point);
+                }
+
+                /**
+                 * Sets the transformation for this grid. The given transformation is expected
+                 * to only consist of a rotation and translation.
+                 */
+                void setTransform(const Eigen::Transform<ScalarType, 3, Eigen::Affine>& tf) {
+                    _mapping.setTransform(tf);
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
+                    return _mapping.getTransform();
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
+                    return _mapping.getInvTransform();
+                }
+
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_OCTREE_GRID_H
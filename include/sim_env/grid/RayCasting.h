@@ -0,0 +1,199 @@
+#ifndef SIM_ENV_GRID_RAY_CASTING_H
+#define SIM_ENV_GRID_RAY_CASTING_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        namespace ray_casting {
+            // Number of rays that are processed as one chunk by castRays.
+            static const size_t RAY_CHUNK_SIZE = 64;
+
+            /**
+             * Maps a ray given in world frame to cell coordinates of a grid with the given mapping and clips it
+             * to the bounds of the grid. The ray parameter remains the distance along the ray in world frame,
+             * i.e. a point of the ray has cell coordinates start + t * dir.
+             * @param mapping - spatial mapping of the grid
+             * @param origin - origin of the ray in world frame
+             * @param direction - direction of the ray in world frame, does not need to be normalized
+             * @param max_distance - maximal distance from origin
+             * @param start - output, origin in cell coordinates
+             * @param dir - output, normalized direction in cell coordinates
+             * @param t_begin - output, distance at which the ray enters the grid
+             * @param t_end - output, distance at which the ray leaves the grid or max_distance
+             * @return whether the ray intersects the grid within max_distance
+             */
+            template<typename ScalarType>
+            bool clipRay(const VoxelGridMapping<ScalarType>& mapping, const Eigen::Matrix<ScalarType, 3, 1>& origin,
+                         const Eigen::Matrix<ScalarType, 3, 1>& direction, const ScalarType& max_distance,
+                         Eigen::Matrix<ScalarType, 3, 1>& start, Eigen::Matrix<ScalarType, 3, 1>& dir,
+                         ScalarType& t_begin, ScalarType& t_end) {
+                const ScalarType norm = direction.norm();
+                if (norm == ScalarType(0)) {
+                    throw std::invalid_argument("The direction of a ray must not be zero.");
+                }
+                const Eigen::Matrix<ScalarType, 3, 4> world_to_cell = mapping.getWorldToCellMatrix();
+                start = world_to_cell.template block<3, 3>(0, 0) * origin + world_to_cell.col(3);
+                dir = world_to_cell.template block<3, 3>(0, 0) * direction / norm;
+                const auto& num_cells = mapping.getNumCells();
+                t_begin = 0;
+                t_end = max_distance;
+                for (unsigned int d = 0; d < 3; ++d) {
+                    if (dir[d] == ScalarType(0)) {
+                        if (start[d] < 0 or start[d] >= (ScalarType)num_cells[d]) return false;
+                        continue;
+                    }
+                    ScalarType t0 = -start[d] / dir[d];
+                    ScalarType t1 = ((ScalarType)num_cells[d] - start[d]) / dir[d];
+                    if (t0 > t1) std::swap(t0, t1);
+                    t_begin = std::max(t_begin, t0);
+                    t_end = std::min(t_end, t1);
+                }
+                return t_begin <= t_end;
+            }
+        }
+
+        /**
+         * The result of casting a single ray, see castRays(..).
+         */
+        template<typename ScalarType>
+        struct RayHit {
+            bool hit;
+            UnsignedIndex idx;
+            ScalarType distance;
+            RayHit() : hit(false), distance(0) {}
+        };
+
+        /**
+         * Visits all cells of grid that the given ray passes through, in order of distance, using the 3D-DDA
+         * by J. Amanatides and A. Woo, "A Fast Voxel Traversal Algorithm for Ray Tracing", 1987.
+         * The ray is given in world frame, i.e. the transform of the grid is taken into account.
+         * Calls fn(const UnsignedIndex& idx, ScalarType t_enter, ScalarType t_exit) for each cell, where
+         * [t_enter, t_exit] is the range of distances from origin for which the ray is within the cell.
+         * fn returns whether to continue the traversal.
+         * @param grid - grid to traverse
+         * @param origin - origin of the ray in world frame
+         * @param direction - direction of the ray in world frame, does not need to be normalized
+         * @param max_distance - maximal distance from origin to traverse
+         * @param fn - function to call for each cell
+         * @return false if fn stopped the traversal, else true
+         */
+        template<typename ScalarType, typename ValueType, typename Layout, typename Function>
+        bool traverseRay(const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+                         const Eigen::Matrix<ScalarType, 3, 1>& origin,
+                         const Eigen::Matrix<ScalarType, 3, 1>& direction,
+                         const ScalarType& max_distance, Function fn) {
+            Eigen::Matrix<ScalarType, 3, 1> start, dir;
+            ScalarType t_begin, t_end;
+            if (not ray_casting::clipRay(grid.getMapping(), origin, direction, max_distance, start, dir, t_begin, t_end)) {
+                return true;
+            }
+            const long sizes[3] = {(long)grid.getXSize(), (long)grid.getYSize(), (long)grid.getZSize()};
+            long cell[3];
+            long step[3];
+            ScalarType t_max[3];
+            ScalarType t_delta[3];
+            for (unsigned int d = 0; d < 3; ++d) {
+                ScalarType coord = std::floor(start[d] + t_begin * dir[d]);
+                cell[d] = std::min(std::max((long)coord, 0l), sizes[d] - 1);
+                if (dir[d] > 0) {
+                    step[d] = 1;
+                    t_max[d] = (ScalarType(cell[d] + 1) - start[d]) / dir[d];
+                    t_delta[d] = ScalarType(1) / dir[d];
+                } else if (dir[d] < 0) {
+                    step[d] = -1;
+                    t_max[d] = (ScalarType(cell[d]) - start[d]) / dir[d];
+                    t_delta[d] = ScalarType(-1) / dir[d];
+                } else {
+                    step[d] = 0;
+                    t_max[d] = std::numeric_limits<ScalarType>::infinity();
+                    t_delta[d] = std::numeric_limits<ScalarType>::infinity();
+                }
+            }
+            ScalarType t = t_begin;
+            while (true) {
+                const unsigned int axis = t_max[0] < t_max[1] ? (t_max[0] < t_max[2] ? 0 : 2)
+                                                              : (t_max[1] < t_max[2] ? 1 : 2);
+                const ScalarType t_exit = std::min(std::max(t_max[axis], t), t_end);
+                if (not fn(UnsignedIndex(cell[0], cell[1], cell[2]), t, t_exit)) {
+                    return false;
+                }
+                if (t_max[axis] >= t_end) {
+                    return true;
+                }
+                cell[axis] += step[axis];
+                if (cell[axis] < 0 or cell[axis] >= sizes[axis]) {
+                    return true;
+                }
+                t = t_exit;
+                t_max[axis] += t_delta[axis];
+            }
+        }
+
+        /**
+         * Casts a ray through grid and returns the first cell along the ray for which is_hit(value) is true.
+         * @param grid - grid to cast the ray through
+         * @param origin - origin of the ray in world frame
+         * @param direction - direction of the ray in world frame, does not need to be normalized
+         * @param max_distance - maximal distance from origin to search for a hit
+         * @param is_hit - unary predicate on ValueType
+         * @param hit_idx - output, the hit cell
+         * @param hit_distance - output, distance from origin at which the ray enters hit_idx
+         * @return whether a hit was found within max_distance
+         */
+        template<typename ScalarType, typename ValueType, typename Layout, typename Predicate>
+        bool castRay(const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+                     const Eigen::Matrix<ScalarType, 3, 1>& origin,
+                     const Eigen::Matrix<ScalarType, 3, 1>& direction,
+                     const ScalarType& max_distance, Predicate is_hit,
+                     UnsignedIndex& hit_idx, ScalarType& hit_distance) {
+            return not traverseRay(grid, origin, direction, max_distance,
+                [&](const UnsignedIndex& idx, const ScalarType& t_enter, const ScalarType&) {
+                    if (is_hit(grid(idx))) {
+                        hit_idx = idx;
+                        hit_distance = t_enter;
+                        return false;
+                    }
+                    return true;
+                });
+        }
+
+        /**
+         * Batched version of castRay. The rays are distributed over multiple threads.
+         * @param grid - grid to cast the rays through
+         * @param origins - origins of the rays in world frame, one per column. If origins has a single column,
+         *                  it is used for all rays, e.g. for the rays of a single sensor.
+         * @param directions - directions of the rays in world frame, one per column
+         * @param max_distance - maximal distance from the origin to search for a hit
+         * @param is_hit - unary predicate on ValueType, called concurrently
+         * @param hits - output, hits[i] is the result for ray i
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         */
+        template<typename ScalarType, typename ValueType, typename Layout, typename Predicate>
+        void castRays(const VoxelGrid<ScalarType, ValueType, Layout>& grid,
+                      const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& origins,
+                      const Eigen::Matrix<ScalarType, 3, Eigen::Dynamic>& directions,
+                      const ScalarType& max_distance, Predicate is_hit,
+                      std::vector<RayHit<ScalarType> >& hits, unsigned int num_threads = 0) {
+            if (origins.cols() != 1 and origins.cols() != directions.cols()) {
+                throw std::invalid_argument("There must be either a single origin or one origin per ray.");
+            }
+            hits.resize(directions.cols());
+            utils::parallel::parallelFor(0, directions.cols(), [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    const Eigen::Matrix<ScalarType, 3, 1> origin = origins.col(origins.cols() == 1 ? 0 : i);
+                    const Eigen::Matrix<ScalarType, 3, 1> direction = directions.col(i);
+                    RayHit<ScalarType>& hit = hits[i];
+                    hit.hit = castRay(grid, origin, direction, max_distance, is_hit, hit.idx, hit.distance);
+                }
+            }, num_threads, ray_casting::RAY_CHUNK_SIZE);
+        }
+    }
+}
+#endif //SIM_ENV_GRID_RAY_CASTING_H
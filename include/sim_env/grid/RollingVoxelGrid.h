@@ -0,0 +1,363 @@
+#ifndef SIM_ENV_GRID_ROLLING_VOXEL_GRID_H
+#define SIM_ENV_GRID_ROLLING_VOXEL_GRID_H
+
+#include <sim_env/Grid.h>
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <stdexcept>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * A RollingVoxelGrid is a voxel grid of fixed size that can be moved through space in steps of whole cells,
+         * e.g. to maintain a robot-centric local map. The grid covers a window of cells of an infinite lattice that
+         * is fixed in the grid's base frame (see setTransform). Moving the window keeps the values of all cells that
+         * remain within it; cells that enter the window are set to the default value.
+         * The values are stored in a circular buffer, i.e. the window origin is stored as an offset into the buffer
+         * along each axis. Hence, moving the window only touches the cells that enter it.
+         * Indices passed to value access functions are relative to the current window, as for VoxelGrid.
+         */
+        template<typename ScalarType, typename ValueType>
+        class RollingVoxelGrid {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+            private:
+                VoxelGridMapping<ScalarType> _mapping;
+                Grid3D<ValueType> _buffer;
+                ValueType _default_value;
+                // min corner of the lattice cell (0, 0, 0) in the base frame
+                Vector3s _anchor;
+                // lattice index of the min cell of the window
+                SignedIndex _origin;
+                // position of the min cell of the window in the buffer
+                size_t _offset[3];
+
+                static inline size_t wrap(const long& value, const size_t& size) {
+                    long result = value % (long)size;
+                    return result < 0 ? (size_t)(result + (long)size) : (size_t)result;
+                }
+
+                inline size_t getBufferIndex(const size_t& idx, const size_t& offset, const size_t& size) const {
+                    size_t result = idx + offset;
+                    return result >= size ? result - size : result;
+                }
+
+                ValueType& get(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    return _buffer(getBufferIndex(ix, _offset[0], _buffer.getXSize()),
+                                   getBufferIndex(iy, _offset[1], _buffer.getYSize()),
+                                   getBufferIndex(iz, _offset[2], _buffer.getZSize()));
+                }
+
+                const ValueType& get(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return _buffer(getBufferIndex(ix, _offset[0], _buffer.getXSize()),
+                                   getBufferIndex(iy, _offset[1], _buffer.getYSize()),
+                                   getBufferIndex(iz, _offset[2], _buffer.getZSize()));
+                }
+
+                // Updates the offsets and the mapping to the current origin and buffer size.
+                void updateWindow() {
+                    _offset[0] = wrap(_origin.ix, _buffer.getXSize());
+                    _offset[1] = wrap(_origin.iy, _buffer.getYSize());
+                    _offset[2] = wrap(_origin.iz, _buffer.getZSize());
+                    const ScalarType cell_size = _mapping.getCellSize();
+                    const auto tf = _mapping.getTransform();
+                    Vector3s min_point = _anchor + Vector3s(_origin.ix, _origin.iy, _origin.iz) * cell_size;
+                    // place the max point in the middle of the last cell so that the mapping computes the same size
+                    Vector3s max_point = min_point + (Vector3s(_buffer.getXSize(), _buffer.getYSize(), _buffer.getZSize())
+                                                      - Vector3s::Constant(0.5)) * cell_size;
+                    _mapping.reset(min_point, max_point, cell_size);
+                    _mapping.setTransform(tf);
+                }
+
+                // Sets all cells of the window with indices in [begin, end) to the default value.
+                void clearBox(const size_t begin[3], const size_t end[3]) {
+                    for (size_t z = begin[2]; z < end[2]; ++z) {
+                        for (size_t y = begin[1]; y < end[1]; ++y) {
+                            for (size_t x = begin[0]; x < end[0]; ++x) {
+                                get(x, y, z) = _default_value;
+                            }
+                        }
+                    }
+                }
+
+            public:
+                /*
+                 * Creates a rolling grid whose initial window covers the given bounding box in the base frame.
+                 * The lattice of the grid is aligned with min_point.
+                 */
+                RollingVoxelGrid(const Vector3s& min_point, const Vector3s& max_point,
+                                 const ScalarType& cell_size, ValueType default_value=ValueType()) :
+                    _mapping(min_point, max_point, cell_size),
+                    _buffer(_mapping.getNumCells()[0], _mapping.getNumCells()[1], _mapping.getNumCells()[2],
+                            default_value),
+                    _default_value(default_value),
+                    _anchor(min_point),
+                    _origin(0, 0, 0)
+                {
+                    updateWindow();
+                }
+
+                RollingVoxelGrid(const RollingVoxelGrid& other) = default;
+                ~RollingVoxelGrid() = default;
+                RollingVoxelGrid& operator=(const RollingVoxelGrid& other) = default;
+
+                inline size_t getXSize() const {
+                    return _buffer.getXSize();
+                }
+
+                inline size_t getYSize() const {
+                    return _buffer.getYSize();
+                }
+
+                inline size_t getZSize() const {
+                    return _buffer.getZSize();
+                }
+
+                inline bool inBounds(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return _buffer.inBounds(ix, iy, iz);
+                }
+
+                inline bool inBounds(const long& ix, const long& iy, const long& iz) const {
+                    return _buffer.inBounds(ix, iy, iz);
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return _buffer.inBounds(idx);
+                }
+
+                inline bool inBounds(const UnsignedIndex& idx) const {
+                    return _buffer.inBounds(idx);
+                }
+
+                ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    return get(ix, iy, iz);
+                }
+
+                ValueType& operator()(const UnsignedIndex& idx) {
+                    return get(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& operator()(const UnsignedIndex& idx) const {
+                    return get(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                ValueType& at(const long& ix, const long& iy, const long& iz) {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                ValueType& at(const SignedIndex& idx) {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType& at(const UnsignedIndex& idx) {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& at(const long& ix, const long& iy, const long& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& at(const UnsignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const SignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& getDefaultValue() const {
+                    return _default_value;
+                }
+
+                /*
+                 * Returns the lattice index of the min cell of the current window. The initial window has origin (0, 0, 0).
+                 */
+                const SignedIndex& getWindowOrigin() const {
+                    return _origin;
+                }
+
+                /*
+                 * Moves the window by the given number of cells along each axis. Cells that remain within the window
+                 * keep their values, but their window-relative indices change by -delta. Cells that enter the window
+                 * are set to the default value.
+                 * @return the number of cells that entered the window
+                 */
+                size_t shift(const SignedIndex& delta) {
+                    const size_t sizes[3] = {getXSize(), getYSize(), getZSize()};
+                    const long deltas[3] = {delta.ix, delta.iy, delta.iz};
+                    _origin += delta;
+                    updateWindow();
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if ((size_t)std::labs(deltas[d]) >= sizes[d]) {
+                            std::fill(_buffer.begin(), _buffer.end(), _default_value);
+                            return sizes[0] * sizes[1] * sizes[2];
+                        }
+                    }
+                    // Clear the new slab along each axis. The slab of axis d excludes cells already cleared by the
+                    // slabs of the previous axes, so that each new cell is written exactly once.
+                    size_t kept_begin[3] = {0, 0, 0};
+                    size_t kept_end[3] = {sizes[0], sizes[1], sizes[2]};
+                    size_t num_cleared = 0;
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (deltas[d] == 0) continue;
+                        size_t begin[3] = {kept_begin[0], kept_begin[1], kept_begin[2]};
+                        size_t end[3] = {kept_end[0], kept_end[1], kept_end[2]};
+                        if (deltas[d] > 0) {
+                            begin[d] = sizes[d] - deltas[d];
+                            end[d] = sizes[d];
+                            kept_end[d] = begin[d];
+                        } else {
+                            begin[d] = 0;
+                            end[d] = (size_t)(-deltas[d]);
+                            kept_begin[d] = end[d];
+                        }
+                        clearBox(begin, end);
+                        num_cleared += (end[0] - begin[0]) * (end[1] - begin[1]) * (end[2] - begin[2]);
+                    }
+                    return num_cleared;
+                }
+
+                /*
+                 * Moves the window such that the given position in world frame lies in its center cell.
+                 * See shift(..).
+                 * @return the number of cells that entered the window
+                 */
+                size_t recenter(const Vector3s& position) {
+                    const Vector3s local = (_mapping.getInvTransform() * position - _anchor) / _mapping.getCellSize();
+                    SignedIndex new_origin((long)std::floor(local[0]) - (long)(getXSize() / 2),
+                                           (long)std::floor(local[1]) - (long)(getYSize() / 2),
+                                           (long)std::floor(local[2]) - (long)(getZSize() / 2));
+                    return shift(new_origin - _origin);
+                }
+
+                /*
+                 * Changes the number of cells of the window while keeping its origin. Cells within both the old
+                 * and new window keep their values, all other cells are set to the default value.
+                 * This reallocates the buffer.
+                 */
+                void resize(const size_t& x_size, const size_t& y_size, const size_t& z_size) {
+                    if (x_size == 0 or y_size == 0 or z_size == 0) {
+                        throw std::invalid_argument("A RollingVoxelGrid must have at least one cell per dimension.");
+                    }
+                    Grid3D<ValueType> buffer(x_size, y_size, z_size, _default_value);
+                    const size_t x_end = std::min(x_size, getXSize());
+                    const size_t y_end = std::min(y_size, getYSize());
+                    const size_t z_end = std::min(z_size, getZSize());
+                    // write the kept cells to the positions of the new circular buffer
+                    const size_t new_offset[3] = {wrap(_origin.ix, x_size), wrap(_origin.iy, y_size),
+                                                  wrap(_origin.iz, z_size)};
+                    for (size_t z = 0; z < z_end; ++z) {
+                        for (size_t y = 0; y < y_end; ++y) {
+                            for (size_t x = 0; x < x_end; ++x) {
+                                buffer(getBufferIndex(x, new_offset[0], x_size), getBufferIndex(y, new_offset[1], y_size),
+                                       getBufferIndex(z, new_offset[2], z_size)) = get(x, y, z);
+                            }
+                        }
+                    }
+                    _buffer = buffer;
+                    updateWindow();
+                }
+
+                /*
+                 * Sets all cells to the default value.
+                 */
+                void clear() {
+                    std::fill(_buffer.begin(), _buffer.end(), _default_value);
+                }
+
+                UnsignedIndexGenerator getIndexGenerator() const {
+                    return UnsignedIndexGenerator(getXSize(), getYSize(), getZSize());
+                }
+
+                UnsignedBoxIndexGenerator getNeighborIndexGenerator(const UnsignedIndex& idx,
+                                                                    const size_t& dx,
+                                                                    const size_t& dy,
+                                                                    const size_t& dz) const {
+                    return UnsignedBoxIndexGenerator(getXSize(), getYSize(), getZSize(), idx, dx, dy, dz);
+                }
+
+                /*
+                * Returns the index of the voxel of the current window in which the specified position in world
+                * frame lies. Note that the returned index may be out of bounds, if the position is out of bounds.
+                */
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    return _mapping.getCellIdx(position);
+                }
+
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    return _mapping.getValidCellIdx(position, is_valid);
+                }
+
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
+                }
+
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                ScalarType getCellSize() const {
+                    return _mapping.getCellSize();
+                }
+
+                /**
+                 * Returns the bounding box of the current window in the base frame.
+                 */
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    min_point = _anchor + Vector3s(_origin.ix, _origin.iy, _origin.iz) * getCellSize();
+                    max_point = min_point + Vector3s(getXSize(), getYSize(), getZSize()) * getCellSize();
+                }
+
+                /**
+                 * Sets the transformation from the base frame to world frame. The given transformation is expected
+                 * to only consist of a rotation and translation.
+                 */
+                void setTransform(const Eigen::Transform<ScalarType, 3, Eigen::Affine>& tf) {
+                    _mapping.setTransform(tf);
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
+                    return _mapping.getTransform();
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
+                    return _mapping.getInvTransform();
+                }
+
+                /**
+                 * Returns the spatial mapping of the current window. It changes whenever the window moves.
+                 */
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_ROLLING_VOXEL_GRID_H
@@ -0,0 +1,318 @@
+#ifndef SIM_ENV_GRID_SPARSE_VOXEL_GRID_H
+#define SIM_ENV_GRID_SPARSE_VOXEL_GRID_H
+
+#include <sim_env/Grid.h>
+#include <unordered_map>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+
+        /**
+         * A SparseVoxelGrid provides the same spatial relations and value access as a VoxelGrid,
+         * but does not allocate memory for the whole bounding box. Instead, values are stored in
+         * bricks of BrickSize x BrickSize x BrickSize cells that are kept in a hash map and only
+         * allocated when a cell within them is written to. Reading a cell of an unallocated brick
+         * yields the default value of the grid.
+         * NOTE: The non-const versions of at(..) and operator()(..) return references and thus
+         * allocate the brick containing the accessed cell. Use a const reference to this grid for
+         * reading if you do not want to allocate memory.
+         */
+        template<typename ScalarType, typename ValueType, size_t BrickSize = 8>
+        class SparseVoxelGrid {
+            public:
+                EIGEN_MAKE_ALIGNED_OPERATOR_NEW
+                typedef Eigen::Matrix<ScalarType, 3, 1> Vector3s;
+                typedef std::vector<ValueType, Eigen::aligned_allocator<ValueType> > Brick;
+                static_assert(BrickSize > 0 and (BrickSize & (BrickSize - 1)) == 0, "BrickSize must be a power of two");
+            private:
+                static constexpr size_t log2(size_t n) {
+                    return n <= 1 ? 0 : 1 + log2(n / 2);
+                }
+                static constexpr size_t BRICK_BITS = log2(BrickSize);
+                static constexpr size_t BRICK_MASK = BrickSize - 1;
+                static constexpr size_t BRICK_VOLUME = BrickSize * BrickSize * BrickSize;
+
+                VoxelGridMapping<ScalarType> _mapping;
+                ValueType _default_value;
+                size_t _x_size;
+                size_t _y_size;
+                size_t _z_size;
+                size_t _x_bricks;
+                size_t _xy_bricks;
+                std::unordered_map<size_t, Brick> _bricks;
+
+                inline size_t getBrickKey(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return (ix >> BRICK_BITS) + (iy >> BRICK_BITS) * _x_bricks + (iz >> BRICK_BITS) * _xy_bricks;
+                }
+
+                inline size_t getInBrickIndex(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return (ix & BRICK_MASK) + ((iy & BRICK_MASK) << BRICK_BITS) + ((iz & BRICK_MASK) << (2 * BRICK_BITS));
+                }
+
+                void computeSizes() {
+                    auto& num_cells = _mapping.getNumCells();
+                    _x_size = num_cells[0];
+                    _y_size = num_cells[1];
+                    _z_size = num_cells[2];
+                    _x_bricks = (_x_size + BRICK_MASK) >> BRICK_BITS;
+                    _xy_bricks = _x_bricks * ((_y_size + BRICK_MASK) >> BRICK_BITS);
+                }
+
+                ValueType& getOrAllocate(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    size_t key = getBrickKey(ix, iy, iz);
+                    auto iter = _bricks.find(key);
+                    if (iter == _bricks.end()) {
+                        iter = _bricks.insert(std::make_pair(key, Brick(BRICK_VOLUME, _default_value))).first;
+                    }
+                    return iter->second[getInBrickIndex(ix, iy, iz)];
+                }
+
+                const ValueType& get(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    auto iter = _bricks.find(getBrickKey(ix, iy, iz));
+                    if (iter == _bricks.end()) {
+                        return _default_value;
+                    }
+                    return iter->second[getInBrickIndex(ix, iy, iz)];
+                }
+
+            public:
+                SparseVoxelGrid(const Vector3s& min_point, const Vector3s& max_point,
+                                const ScalarType& cell_size, ValueType default_value=ValueType()) :
+                    _mapping(min_point, max_point, cell_size),
+                    _default_value(default_value)
+                {
+                    computeSizes();
+                }
+
+                SparseVoxelGrid(const SparseVoxelGrid& other) = default;
+                ~SparseVoxelGrid() = default;
+                SparseVoxelGrid& operator=(const SparseVoxelGrid& other) = default;
+
+                inline size_t getXSize() const {
+                    return _x_size;
+                }
+
+                inline size_t getYSize() const {
+                    return _y_size;
+                }
+
+                inline size_t getZSize() const {
+                    return _z_size;
+                }
+
+                inline bool inBounds(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return ix < _x_size && iy < _y_size && iz < _z_size;
+                }
+
+                inline bool inBounds(const long& ix, const long& iy, const long& iz) const {
+                    return ix >= 0 and iy >= 0 and iz >= 0 and ix < _x_size and iy < _y_size and iz < _z_size;
+                }
+
+                inline bool inBounds(const SignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                inline bool inBounds(const UnsignedIndex& idx) const {
+                    return inBounds(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    return getOrAllocate(ix, iy, iz);
+                }
+
+                ValueType& operator()(const UnsignedIndex& idx) {
+                    return operator()(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& operator()(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& operator()(const UnsignedIndex& idx) const {
+                    return operator()(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return getOrAllocate(ix, iy, iz);
+                }
+
+                ValueType& at(const long& ix, const long& iy, const long& iz) {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return getOrAllocate(ix, iy, iz);
+                }
+
+                ValueType& at(const SignedIndex& idx) {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                ValueType& at(const UnsignedIndex& idx) {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const size_t& ix, const size_t& iy, const size_t& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& at(const long& ix, const long& iy, const long& iz) const {
+                    if (not inBounds(ix, iy, iz)) {
+                        throw std::out_of_range("The provided index is out of range for this grid.");
+                    }
+                    return get(ix, iy, iz);
+                }
+
+                const ValueType& at(const UnsignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                const ValueType& at(const SignedIndex& idx) const {
+                    return at(idx.ix, idx.iy, idx.iz);
+                }
+
+                /*
+                 * Returns whether the brick containing the given cell is allocated.
+                 */
+                bool isAllocated(const UnsignedIndex& idx) const {
+                    return _bricks.find(getBrickKey(idx.ix, idx.iy, idx.iz)) != _bricks.end();
+                }
+
+                const ValueType& getDefaultValue() const {
+                    return _default_value;
+                }
+
+                size_t getNumAllocatedBricks() const {
+                    return _bricks.size();
+                }
+
+                /*
+                 * Returns the number of bytes occupied by the values of allocated bricks.
+                 * This does not include the overhead of the hash map itself.
+                 */
+                size_t getAllocatedMemory() const {
+                    return _bricks.size() * BRICK_VOLUME * sizeof(ValueType);
+                }
+
+                /*
+                 * Releases all bricks, i.e. resets all cells to the default value.
+                 */
+                void clear() {
+                    _bricks.clear();
+                }
+
+                /*
+                 * Releases all bricks in which all cells are equal to the default value.
+                 * Requires ValueType to be comparable with operator==.
+                 * @return number of released bricks
+                 */
+                size_t prune() {
+                    size_t num_released = 0;
+                    for (auto iter = _bricks.begin(); iter != _bricks.end();) {
+                        bool all_default = std::all_of(iter->second.begin(), iter->second.end(),
+                            [this](const ValueType& value) { return value == _default_value; });
+                        if (all_default) {
+                            iter = _bricks.erase(iter);
+                            ++num_released;
+                        } else {
+                            ++iter;
+                        }
+                    }
+                    return num_released;
+                }
+
+                /*
+                 * Calls fn(const UnsignedIndex& idx, const ValueType& value) for each cell
+                 * within the bounds of this grid that lies in an allocated brick.
+                 * The order in which cells are visited is unspecified.
+                 */
+                template<typename Function>
+                void forEachAllocatedCell(Function fn) const {
+                    for (auto& key_brick : _bricks) {
+                        size_t bz = key_brick.first / _xy_bricks;
+                        size_t by = (key_brick.first % _xy_bricks) / _x_bricks;
+                        size_t bx = key_brick.first % _x_bricks;
+                        UnsignedIndex base(bx << BRICK_BITS, by << BRICK_BITS, bz << BRICK_BITS);
+                        size_t x_end = std::min(BrickSize, _x_size - base.ix);
+                        size_t y_end = std::min(BrickSize, _y_size - base.iy);
+                        size_t z_end = std::min(BrickSize, _z_size - base.iz);
+                        for (size_t z = 0; z < z_end; ++z) {
+                            for (size_t y = 0; y < y_end; ++y) {
+                                for (size_t x = 0; x < x_end; ++x) {
+                                    fn(UnsignedIndex(base.ix + x, base.iy + y, base.iz + z),
+                                       key_brick.second[getInBrickIndex(x, y, z)]);
+                                }
+                            }
+                        }
+                    }
+                }
+
+                UnsignedIndexGenerator getIndexGenerator() const {
+                    return UnsignedIndexGenerator(_x_size, _y_size, _z_size);
+                }
+
+                UnsignedBoxIndexGenerator getNeighborIndexGenerator(const UnsignedIndex& idx,
+                                                                    const size_t& dx,
+                                                                    const size_t& dy,
+                                                                    const size_t& dz) const {
+                    return UnsignedBoxIndexGenerator(_x_size, _y_size, _z_size, idx, dx, dy, dz);
+                }
+
+                /*
+                * Returns the index of the voxel in which the specified position in world frame lies.
+                * Note that the returned index may be out of bounds, if the position is out of bounds.
+                * You can check this by calling inBounds(idx). Alternatively, use getValidCellIdx(..)
+                */
+                SignedIndex getCellIdx(const Vector3s& position) const {
+                    return _mapping.getCellIdx(position);
+                }
+
+                UnsignedIndex getValidCellIdx(const Vector3s& position, bool& is_valid) const {
+                    return _mapping.getValidCellIdx(position, is_valid);
+                }
+
+                bool mapToGrid(const Vector3s& in_position, Vector3s& out_pos, UnsignedIndex& idx) const {
+                    return _mapping.mapToGrid(in_position, out_pos, idx);
+                }
+
+                void getCellPosition(const UnsignedIndex& idx, Vector3s& position, bool b_center) const {
+                    _mapping.getCellPosition(idx, position, b_center);
+                }
+
+                ScalarType getCellSize() const {
+                    return _mapping.getCellSize();
+                }
+
+                void getBoundingBox(Vector3s& min_point, Vector3s& max_point) const {
+                    _mapping.getBoundingBox(min_point, max_point);
+                }
+
+                /**
+                 * Sets the transformation for this grid. The given transformation is expected
+                 * to only consist of a rotation and translation.
+                 */
+                void setTransform(const Eigen::Transform<ScalarType, 3, Eigen::Affine>& tf) {
+                    _mapping.setTransform(tf);
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getTransform() const {
+                    return _mapping.getTransform();
+                }
+
+                Eigen::Transform<ScalarType, 3, Eigen::Affine> getInvTransform() const {
+                    return _mapping.getInvTransform();
+                }
+
+                const VoxelGridMapping<ScalarType>& getMapping() const {
+                    return _mapping;
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_SPARSE_VOXEL_GRID_H
@@ -0,0 +1,349 @@
+#ifndef SIM_ENV_GRID_VOXEL_GRID_PYRAMID_H
+#define SIM_ENV_GRID_VOXEL_GRID_PYRAMID_H
+
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <stdexcept>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        /**
+         * Defines how the values of (up to) 2 x 2 x 2 cells of one level of a VoxelGridPyramid are combined
+         * into the value of the corresponding cell of the next coarser level.
+         */
+        enum class PyramidReduction {
+            Min, Max, Mean
+        };
+
+        /**
+         * A VoxelGridPyramid stores successively coarser versions of a VoxelGrid. Level 0 is a copy of the
+         * original grid and each cell of level l + 1 covers 2 x 2 x 2 cells of level l. All levels share the
+         * bounding box and transform of the original grid.
+         * For Min and Max pyramids, box queries are answered coarse-to-fine: a coarse cell that already decides
+         * the query is not refined, so large uniform regions are handled in constant time.
+         */
+        template<typename ScalarType, typename ValueType, typename Layout = RowMajorLayout>
+        class VoxelGridPyramid {
+            public:
+                typedef VoxelGrid<ScalarType, ValueType, Layout> LevelGrid;
+                typedef typename LevelGrid::Vector3s Vector3s;
+
+                /*
+                 * Builds the pyramid for the given grid.
+                 * @param grid - the finest level
+                 * @param reduction - how cells are combined into coarser cells
+                 * @param max_levels - maximal number of levels (including level 0), 0 for building levels until
+                 *                     the coarsest level consists of a single cell
+                 * @param num_threads - maximal number of threads to use for building, 0 for all available
+                 */
+                VoxelGridPyramid(const LevelGrid& grid, PyramidReduction reduction, size_t max_levels = 0,
+                                 unsigned int num_threads = 0) :
+                    _reduction(reduction)
+                {
+                    _levels.push_back(grid);
+                    build(max_levels, num_threads);
+                }
+
+                /*
+                 * Rebuilds all levels from the given grid, which must have the same size as level 0.
+                 */
+                void update(const LevelGrid& grid, unsigned int num_threads = 0) {
+                    if (grid.getXSize() != _levels[0].getXSize() or grid.getYSize() != _levels[0].getYSize()
+                        or grid.getZSize() != _levels[0].getZSize()) {
+                        throw std::invalid_argument("The grid must have the same size as level 0 of the pyramid.");
+                    }
+                    size_t num_levels = _levels.size();
+                    _levels.resize(1);
+                    _levels[0] = grid;
+                    build(num_levels, num_threads);
+                }
+
+                size_t getNumLevels() const {
+                    return _levels.size();
+                }
+
+                PyramidReduction getReduction() const {
+                    return _reduction;
+                }
+
+                const LevelGrid& getLevel(size_t level) const {
+                    return _levels.at(level);
+                }
+
+                /*
+                 * Computes the range of cells of level 0 that covers the given axis aligned box in world frame.
+                 * @param min_point, max_point - box in world frame
+                 * @param min_idx, max_idx - output, inclusive range of cells clipped to the grid
+                 * @return false if the box does not overlap the grid
+                 */
+                bool getCellRange(const Vector3s& min_point, const Vector3s& max_point,
+                                  UnsignedIndex& min_idx, UnsignedIndex& max_idx) const {
+                    const VoxelGridMapping<ScalarType>& mapping = _levels[0].getMapping();
+                    // bounding box of the corners of the world box in cell coordinates
+                    Vector3s min_coords = Vector3s::Constant(std::numeric_limits<ScalarType>::max());
+                    Vector3s max_coords = Vector3s::Constant(std::numeric_limits<ScalarType>::lowest());
+                    for (unsigned int corner = 0; corner < 8; ++corner) {
+                        Vector3s point((corner & 1) ? max_point[0] : min_point[0],
+                                       (corner & 2) ? max_point[1] : min_point[1],
+                                       (corner & 4) ? max_point[2] : min_point[2]);
+                        Vector3s coords = mapping.getCellCoordinates(point);
+                        min_coords = min_coords.cwiseMin(coords);
+                        max_coords = max_coords.cwiseMax(coords);
+                    }
+                    const size_t sizes[3] = {_levels[0].getXSize(), _levels[0].getYSize(), _levels[0].getZSize()};
+                    size_t lower[3], upper[3];
+                    for (unsigned int d = 0; d < 3; ++d) {
+                        if (max_coords[d] < 0 or min_coords[d] >= (ScalarType)sizes[d]) {
+                            return false;
+                        }
+                        lower[d] = (size_t)std::max(ScalarType(0), std::floor(min_coords[d]));
+                        upper[d] = std::min(sizes[d] - 1, (size_t)std::floor(max_coords[d]));
+                    }
+                    min_idx = UnsignedIndex(lower[0], lower[1], lower[2]);
+                    max_idx = UnsignedIndex(upper[0], upper[1], upper[2]);
+                    return true;
+                }
+
+                /*
+                 * Returns the minimum (Min pyramid) or maximum (Max pyramid) of all cells of level 0 within
+                 * the inclusive range [min_idx, max_idx]. Cells fully covered by a coarse cell are not visited.
+                 * Throws std::logic_error for Mean pyramids and std::out_of_range for invalid ranges.
+                 */
+                ValueType getBoxValue(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx) const {
+                    checkRange(min_idx, max_idx);
+                    if (_reduction == PyramidReduction::Mean) {
+                        throw std::logic_error("Box values are only supported by Min and Max pyramids.");
+                    }
+                    bool has_value = false;
+                    ValueType value = ValueType();
+                    forEachCoarsestCell(min_idx, max_idx, [&](size_t level, const UnsignedIndex& cell) {
+                        accumulateBoxValue(level, cell, min_idx, max_idx, has_value, value);
+                        return true;
+                    });
+                    return value;
+                }
+
+                /*
+                 * Returns whether all cells of level 0 within the inclusive range [min_idx, max_idx] have a value
+                 * smaller than threshold, e.g. whether a box is free in a Max pyramid of occupancy or cost values.
+                 * Coarse cells with a maximum below the threshold accept, and coarse cells that are fully within
+                 * the range and have a maximum not below the threshold reject, without visiting finer levels.
+                 * Requires a Max pyramid, throws std::logic_error otherwise.
+                 */
+                bool isBoxBelow(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx,
+                                const ValueType& threshold) const {
+                    checkRange(min_idx, max_idx);
+                    if (_reduction != PyramidReduction::Max) {
+                        throw std::logic_error("isBoxBelow requires a Max pyramid.");
+                    }
+                    return allSatisfy(min_idx, max_idx, [&threshold](const ValueType& v) { return v < threshold; });
+                }
+
+                /*
+                 * World frame version of isBoxBelow. Returns true if the box does not overlap the grid.
+                 */
+                bool isBoxBelow(const Vector3s& min_point, const Vector3s& max_point, const ValueType& threshold) const {
+                    UnsignedIndex min_idx, max_idx;
+                    if (not getCellRange(min_point, max_point, min_idx, max_idx)) {
+                        return true;
+                    }
+                    return isBoxBelow(min_idx, max_idx, threshold);
+                }
+
+                /*
+                 * Returns whether all cells of level 0 within the inclusive range [min_idx, max_idx] have a value
+                 * larger than threshold, e.g. whether a box has a minimal clearance in a Min pyramid of distances.
+                 * Requires a Min pyramid, throws std::logic_error otherwise.
+                 */
+                bool isBoxAbove(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx,
+                                const ValueType& threshold) const {
+                    checkRange(min_idx, max_idx);
+                    if (_reduction != PyramidReduction::Min) {
+                        throw std::logic_error("isBoxAbove requires a Min pyramid.");
+                    }
+                    return allSatisfy(min_idx, max_idx, [&threshold](const ValueType& v) { return v > threshold; });
+                }
+
+                /*
+                 * World frame version of isBoxAbove. Returns true if the box does not overlap the grid.
+                 */
+                bool isBoxAbove(const Vector3s& min_point, const Vector3s& max_point, const ValueType& threshold) const {
+                    UnsignedIndex min_idx, max_idx;
+                    if (not getCellRange(min_point, max_point, min_idx, max_idx)) {
+                        return true;
+                    }
+                    return isBoxAbove(min_idx, max_idx, threshold);
+                }
+
+            private:
+                PyramidReduction _reduction;
+                std::vector<LevelGrid, Eigen::aligned_allocator<LevelGrid> > _levels;
+
+                void build(size_t max_levels, unsigned int num_threads) {
+                    Vector3s min_point, max_point;
+                    _levels[0].getBoundingBox(min_point, max_point);
+                    while ((max_levels == 0 or _levels.size() < max_levels) and
+                           (_levels.back().getXSize() > 1 or _levels.back().getYSize() > 1
+                            or _levels.back().getZSize() > 1)) {
+                        // Since the cell size doubles exactly, the number of cells of the coarser level is
+                        // exactly ceil(n / 2) of the finer level.
+                        LevelGrid coarse(min_point, max_point, 2 * _levels.back().getCellSize());
+                        coarse.setTransform(_levels[0].getTransform());
+                        reduceLevel(_levels.back(), coarse, num_threads);
+                        _levels.push_back(coarse);
+                    }
+                }
+
+                void reduceLevel(const LevelGrid& fine, LevelGrid& coarse, unsigned int num_threads) const {
+                    utils::parallel::parallelFor(0, coarse.getZSize(), [&](size_t z_begin, size_t z_end) {
+                        for (size_t z = z_begin; z < z_end; ++z) {
+                            for (size_t y = 0; y < coarse.getYSize(); ++y) {
+                                for (size_t x = 0; x < coarse.getXSize(); ++x) {
+                                    coarse(x, y, z) = reduceChildren(fine, x, y, z);
+                                }
+                            }
+                        }
+                    }, num_threads);
+                }
+
+                ValueType reduceChildren(const LevelGrid& fine, size_t x, size_t y, size_t z) const {
+                    const size_t x_end = std::min(2 * x + 2, fine.getXSize());
+                    const size_t y_end = std::min(2 * y + 2, fine.getYSize());
+                    const size_t z_end = std::min(2 * z + 2, fine.getZSize());
+                    ValueType result = fine(2 * x, 2 * y, 2 * z);
+                    size_t count = 0;
+                    for (size_t cz = 2 * z; cz < z_end; ++cz) {
+                        for (size_t cy = 2 * y; cy < y_end; ++cy) {
+                            for (size_t cx = 2 * x; cx < x_end; ++cx) {
+                                const ValueType& value = fine(cx, cy, cz);
+                                switch (_reduction) {
+                                    case PyramidReduction::Min:
+                                        result = std::min(result, value);
+                                        break;
+                                    case PyramidReduction::Max:
+                                        result = std::max(result, value);
+                                        break;
+                                    case PyramidReduction::Mean:
+                                        result = count == 0 ? value : result + value;
+                                        break;
+                                }
+                                ++count;
+                            }
+                        }
+                    }
+                    if (_reduction == PyramidReduction::Mean) {
+                        result = result / (ValueType)count;
+                    }
+                    return result;
+                }
+
+                void checkRange(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx) const {
+                    if (not _levels[0].inBounds(min_idx) or not _levels[0].inBounds(max_idx)
+                        or min_idx.ix > max_idx.ix or min_idx.iy > max_idx.iy or min_idx.iz > max_idx.iz) {
+                        throw std::out_of_range("The provided cell range is invalid for this grid.");
+                    }
+                }
+
+                // Calls fn(level, cell) for all cells of the coarsest level that overlap the range of level 0 cells.
+                // Stops and returns false as soon as fn returns false.
+                template<typename Function>
+                bool forEachCoarsestCell(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx,
+                                         Function fn) const {
+                    const size_t level = _levels.size() - 1;
+                    for (size_t z = min_idx.iz >> level; z <= (max_idx.iz >> level); ++z) {
+                        for (size_t y = min_idx.iy >> level; y <= (max_idx.iy >> level); ++y) {
+                            for (size_t x = min_idx.ix >> level; x <= (max_idx.ix >> level); ++x) {
+                                if (not fn(level, UnsignedIndex(x, y, z))) {
+                                    return false;
+                                }
+                            }
+                        }
+                    }
+                    return true;
+                }
+
+                // Returns whether the given cell of the given level only covers cells of level 0 within the range.
+                static bool isCovered(size_t level, const UnsignedIndex& cell, const UnsignedIndex& min_idx,
+                                      const UnsignedIndex& max_idx) {
+                    const size_t last = (size_t(1) << level) - 1;
+                    return (cell.ix << level) >= min_idx.ix and (cell.ix << level) + last <= max_idx.ix and
+                           (cell.iy << level) >= min_idx.iy and (cell.iy << level) + last <= max_idx.iy and
+                           (cell.iz << level) >= min_idx.iz and (cell.iz << level) + last <= max_idx.iz;
+                }
+
+                // Calls fn(child) for all children of the given cell that overlap the range of level 0 cells.
+                template<typename Function>
+                bool forEachChild(size_t level, const UnsignedIndex& cell, const UnsignedIndex& min_idx,
+                                  const UnsignedIndex& max_idx, Function fn) const {
+                    const size_t child_level = level - 1;
+                    const LevelGrid& child_grid = _levels[child_level];
+                    const size_t x_begin = std::max(2 * cell.ix, min_idx.ix >> child_level);
+                    const size_t y_begin = std::max(2 * cell.iy, min_idx.iy >> child_level);
+                    const size_t z_begin = std::max(2 * cell.iz, min_idx.iz >> child_level);
+                    const size_t x_end = std::min(std::min(2 * cell.ix + 2, child_grid.getXSize()),
+                                                  (max_idx.ix >> child_level) + 1);
+                    const size_t y_end = std::min(std::min(2 * cell.iy + 2, child_grid.getYSize()),
+                                                  (max_idx.iy >> child_level) + 1);
+                    const size_t z_end = std::min(std::min(2 * cell.iz + 2, child_grid.getZSize()),
+                                                  (max_idx.iz >> child_level) + 1);
+                    for (size_t z = z_begin; z < z_end; ++z) {
+                        for (size_t y = y_begin; y < y_end; ++y) {
+                            for (size_t x = x_begin; x < x_end; ++x) {
+                                if (not fn(UnsignedIndex(x, y, z))) {
+                                    return false;
+                                }
+                            }
+                        }
+                    }
+                    return true;
+                }
+
+                template<typename Predicate>
+                bool allSatisfy(const UnsignedIndex& min_idx, const UnsignedIndex& max_idx, const Predicate& pred) const {
+                    return forEachCoarsestCell(min_idx, max_idx, [&](size_t level, const UnsignedIndex& cell) {
+                        return cellSatisfies(level, cell, min_idx, max_idx, pred);
+                    });
+                }
+
+                // Relies on pred being monotone w.r.t. the reduction, i.e. if the reduced value of a cell satisfies
+                // pred, so do all of its children, and otherwise at least one child does not.
+                template<typename Predicate>
+                bool cellSatisfies(size_t level, const UnsignedIndex& cell, const UnsignedIndex& min_idx,
+                                   const UnsignedIndex& max_idx, const Predicate& pred) const {
+                    if (pred(_levels[level](cell))) {
+                        return true;
+                    }
+                    if (level == 0 or isCovered(level, cell, min_idx, max_idx)) {
+                        return false;
+                    }
+                    return forEachChild(level, cell, min_idx, max_idx, [&](const UnsignedIndex& child) {
+                        return cellSatisfies(level - 1, child, min_idx, max_idx, pred);
+                    });
+                }
+
+                void accumulateBoxValue(size_t level, const UnsignedIndex& cell, const UnsignedIndex& min_idx,
+                                        const UnsignedIndex& max_idx, bool& has_value, ValueType& value) const {
+                    if (level == 0 or isCovered(level, cell, min_idx, max_idx)) {
+                        const ValueType& cell_value = _levels[level](cell);
+                        if (not has_value) {
+                            value = cell_value;
+                            has_value = true;
+                        } else {
+                            value = _reduction == PyramidReduction::Min ? std::min(value, cell_value)
+                                                                        : std::max(value, cell_value);
+                        }
+                        return;
+                    }
+                    forEachChild(level, cell, min_idx, max_idx, [&](const UnsignedIndex& child) {
+                        accumulateBoxValue(level - 1, child, min_idx, max_idx, has_value, value);
+                        return true;
+                    });
+                }
+        };
+    }
+}
+#endif //SIM_ENV_GRID_VOXEL_GRID_PYRAMID_H
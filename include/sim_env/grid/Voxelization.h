@@ -0,0 +1,188 @@
+#ifndef SIM_ENV_GRID_VOXELIZATION_H
+#define SIM_ENV_GRID_VOXELIZATION_H
+
+#include <sim_env/SimEnv.h>
+#include <sim_env/Grid.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <array>
+#include <tuple>
+#include <vector>
+
+namespace sim_env {
+    namespace grid {
+        namespace voxelization {
+            /**
+             * Tests whether the triangle (v0, v1, v2) overlaps the axis aligned box with the given center
+             * and half extents using the separating axis test by T. Akenine-Moeller,
+             * "Fast 3D Triangle-Box Overlap Testing", 2001.
+             */
+            bool triangleBoxOverlap(const Eigen::Vector3f& box_center, const Eigen::Vector3f& box_half_size,
+                                    const Eigen::Vector3f& v0, const Eigen::Vector3f& v1, const Eigen::Vector3f& v2);
+
+            /**
+             * Transforms the vertices of the given geometry to the cell coordinates of a voxel grid with the
+             * given mapping. In cell coordinates each cell is a unit cube and cell (x, y, z) spans
+             * [x, x + 1] x [y, y + 1] x [z, z + 1].
+             * @param geometry - the geometry to transform
+             * @param tf - transform from the frame of the geometry to world frame
+             * @param mapping - spatial mapping of the grid
+             * @param vertices - output, vertices[i] is geometry.vertices[i] in cell coordinates
+             */
+            void transformToCells(const Geometry& geometry, const Eigen::Affine3f& tf,
+                                  const VoxelGridMapping<float>& mapping, std::vector<Eigen::Vector3f>& vertices);
+
+            /**
+             * Computes all cells that overlap any of the triangles [begin, end) of a mesh.
+             * Cells may be reported multiple times.
+             * @param vertices - vertices of the mesh in cell coordinates, see transformToCells(..)
+             * @param triangles - triangles of the mesh
+             * @param begin, end - range of triangles to rasterize
+             * @param num_cells - number of cells of the grid along each axis
+             * @param cells - output, cell indices are appended
+             */
+            void rasterizeTriangles(const std::vector<Eigen::Vector3f>& vertices,
+                                    const std::vector<std::tuple<unsigned int, unsigned int, unsigned int> >& triangles,
+                                    size_t begin, size_t end, const std::array<size_t, 3>& num_cells,
+                                    std::vector<UnsignedIndex>& cells);
+
+            /**
+             * Computes all cells that overlap the area enclosed by a polygon, see rasterizeGeometry(..).
+             * @param vertices - vertices of the polygon in cell coordinates, see transformToCells(..)
+             * @param num_cells - number of cells of the grid along each axis
+             * @param cells - output, cell indices are appended
+             */
+            void rasterizePolygon(const std::vector<Eigen::Vector3f>& vertices, const std::array<size_t, 3>& num_cells,
+                                  std::vector<UnsignedIndex>& cells);
+
+            /**
+             * Computes all cells of a voxel grid with the given mapping that overlap the given geometry.
+             * For meshes, a cell is reported if any of the triangles overlaps it. For polygons, a cell is reported
+             * if it overlaps the area enclosed by the polygon. Polygons are assumed to be parallel to the local
+             * xy-plane of the grid and are only filled into the z-layers spanned by their vertices.
+             * Cells may be reported multiple times.
+             * @param geometry - the geometry to rasterize
+             * @param tf - transform from the frame of the geometry to world frame
+             * @param mapping - spatial mapping of the grid
+             * @param cells - output, cell indices are appended
+             */
+            void rasterizeGeometry(const Geometry& geometry, const Eigen::Affine3f& tf,
+                                   const VoxelGridMapping<float>& mapping, std::vector<UnsignedIndex>& cells);
+
+            /**
+             * Collects the geometries of the given link together with the transform from the link frame
+             * to world frame.
+             * The geometry of a link is assumed to be given in the link's frame.
+             */
+            void collectGeometries(LinkConstPtr link, std::vector<Geometry>& geometries,
+                                   std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> >& transforms);
+
+            /**
+             * Collects the geometries of all links of the given object, see collectGeometries(LinkConstPtr, ...).
+             */
+            void collectGeometries(ObjectConstPtr object, std::vector<Geometry>& geometries,
+                                   std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> >& transforms);
+        }
+
+        /**
+         * Sets all cells of the given grid that overlap any of the given geometries to value.
+         * Meshes are split into chunks of triangles that are rasterized in parallel, hence a single large mesh
+         * is voxelized in parallel, too. Polygons are rasterized as a whole.
+         * The cells are written sequentially afterwards. Since all writes set the same value, the result does not
+         * depend on the order of the chunks.
+         * @param geometries - geometries to voxelize
+         * @param transforms - transforms[i] is the transform from the frame of geometries[i] to world frame
+         * @param grid - grid to fill
+         * @param value - value to write into all overlapping cells
+         * @param num_threads - maximal number of threads to use, 0 for all available
+         * @return number of written cells (counting cells that are overlapped by multiple triangles or geometries
+         *      multiple times)
+         */
+        template<typename ValueType, typename Layout>
+        size_t voxelize(const std::vector<Geometry>& geometries,
+                        const std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> >& transforms,
+                        VoxelGrid<float, ValueType, Layout>& grid, const ValueType& value, unsigned int num_threads = 0) {
+            if (geometries.size() != transforms.size()) {
+                throw std::invalid_argument("There must be exactly one transform per geometry.");
+            }
+            /* number of triangles rasterized by one task */
+            static const size_t TRIANGLES_PER_TASK = 256;
+            const VoxelGridMapping<float>& mapping = grid.getMapping();
+            const std::array<size_t, 3> num_grid_cells = mapping.getNumCells();
+            std::vector<std::vector<Eigen::Vector3f> > vertices(geometries.size());
+            utils::parallel::parallelFor(0, geometries.size(), [&](size_t begin, size_t end) {
+                for (size_t i = begin; i < end; ++i) {
+                    voxelization::transformToCells(geometries[i], transforms[i], mapping, vertices[i]);
+                }
+            }, num_threads);
+            /* tasks are (geometry index, first triangle, end of triangles) */
+            std::vector<std::array<size_t, 3> > tasks;
+            for (size_t i = 0; i < geometries.size(); ++i) {
+                if (geometries[i].is_polygon) {
+                    tasks.push_back({{i, 0, 0}});
+                    continue;
+                }
+                const size_t num_triangles = geometries[i].triangles.size();
+                for (size_t t = 0; t < num_triangles; t += TRIANGLES_PER_TASK) {
+                    tasks.push_back({{i, t, std::min(t + TRIANGLES_PER_TASK, num_triangles)}});
+                }
+            }
+            std::vector<std::vector<UnsignedIndex> > cells(tasks.size());
+            utils::parallel::parallelFor(0, tasks.size(), [&](size_t begin, size_t end) {
+                for (size_t k = begin; k < end; ++k) {
+                    const std::array<size_t, 3>& task = tasks[k];
+                    const Geometry& geometry = geometries[task[0]];
+                    if (geometry.is_polygon) {
+                        voxelization::rasterizePolygon(vertices[task[0]], num_grid_cells, cells[k]);
+                    } else {
+                        voxelization::rasterizeTriangles(vertices[task[0]], geometry.triangles, task[1], task[2],
+                                                         num_grid_cells, cells[k]);
+                    }
+                }
+            }, num_threads);
+            size_t num_cells = 0;
+            for (auto& task_cells : cells) {
+                for (auto& idx : task_cells) {
+                    grid(idx) = value;
+                }
+                num_cells += task_cells.size();
+            }
+            return num_cells;
+        }
+
+        /**
+         * Sets all cells of the given grid that overlap the geometry of the given link to value.
+         * See voxelize(..) above.
+         */
+        template<typename ValueType, typename Layout>
+        size_t voxelizeLink(LinkConstPtr link, VoxelGrid<float, ValueType, Layout>& grid, const ValueType& value,
+                            unsigned int num_threads = 0) {
+            std::vector<Geometry> geometries;
+            std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > transforms;
+            voxelization::collectGeometries(link, geometries, transforms);
+            return voxelize(geometries, transforms, grid, value, num_threads);
+        }
+
+        /**
+         * Sets all cells of the given grid that overlap the geometry of any of the given objects to value.
+         * See voxelize(..) above.
+         */
+        template<typename ValueType, typename Layout>
+        size_t voxelizeObjects(const std::vector<ObjectConstPtr>& objects, VoxelGrid<float, ValueType, Layout>& grid,
+                               const ValueType& value, unsigned int num_threads = 0) {
+            std::vector<Geometry> geometries;
+            std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f> > transforms;
+            for (auto& object : objects) {
+                voxelization::collectGeometries(object, geometries, transforms);
+            }
+            return voxelize(geometries, transforms, grid, value, num_threads);
+        }
+
+        template<typename ValueType, typename Layout>
+        size_t voxelizeObject(ObjectConstPtr object, VoxelGrid<float, ValueType, Layout>& grid,
+                              const ValueType& value, unsigned int num_threads = 0) {
+            return voxelizeObjects(std::vector<ObjectConstPtr>(1, object), grid, value, num_threads);
+        }
+    }
+}
+#endif //SIM_ENV_GRID_VOXELIZATION_H
@@ -0,0 +1,74 @@
+//
+// Utilities to distribute work over multiple threads.
+//
+
+#ifndef SIM_ENV_PARALLELUTILS_H
+#define SIM_ENV_PARALLELUTILS_H
+
+#include <condition_variable>
+#include <deque>
+#include <functional>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+namespace sim_env {
+    namespace utils {
+        namespace parallel {
+            /**
+             * A simple pool of worker threads that execute submitted tasks in FIFO order.
+             */
+            class ThreadPool {
+            public:
+                /**
+                 * Creates a new thread pool.
+                 * @param num_threads - number of worker threads. If 0, the number of hardware threads is used.
+                 */
+                explicit ThreadPool(unsigned int num_threads = 0);
+                ~ThreadPool();
+                ThreadPool(const ThreadPool& other) = delete;
+                ThreadPool& operator=(const ThreadPool& other) = delete;
+
+                /**
+                 * Enqueues the given task. The task is executed by one of the worker threads.
+                 * Tasks must not throw exceptions.
+                 */
+                void submit(std::function<void()> task);
+                unsigned int getNumThreads() const;
+
+                /**
+                 * Returns a process wide thread pool with as many workers as there are hardware threads.
+                 * The pool is created on first use.
+                 */
+                static ThreadPool& getDefaultPool();
+
+            private:
+                std::vector<std::thread> _workers;
+                std::deque<std::function<void()>> _tasks;
+                std::mutex _mutex;
+                std::condition_variable _condition;
+                bool _stop;
+                void work();
+            };
+
+            /**
+             * Splits the range [begin, end) into consecutive chunks and calls fn(chunk_begin, chunk_end)
+             * for each of them. The chunks are processed by the calling thread and the workers of the default
+             * thread pool. This function returns once all chunks are processed. If fn throws, the first
+             * exception is rethrown in the calling thread after all other chunks are processed.
+             * It is safe to call this function from within a task executed by the default thread pool.
+             * @param begin - first index of the range
+             * @param end - end of the range (exclusive)
+             * @param fn - function to call for each chunk. Must be safe to be called concurrently.
+             * @param num_threads - maximal number of threads to use (including the calling thread).
+             *                      If 0, all threads of the default pool are used. If 1, everything is executed
+             *                      in the calling thread.
+             * @param min_chunk_size - minimal number of indices per chunk
+             */
+            void parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& fn,
+                             unsigned int num_threads = 0, size_t min_chunk_size = 1);
+        }
+    }
+}
+
+#endif //SIM_ENV_PARALLELUTILS_H
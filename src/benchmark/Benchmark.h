@@ -0,0 +1,53 @@
+//
+// Shared helpers of the sim_env benchmarks.
+//
+
+#ifndef SIM_ENV_BENCHMARK_H
+#define SIM_ENV_BENCHMARK_H
+
+#include <algorithm>
+#include <chrono>
+#include <limits>
+#include <string>
+#include <vector>
+
+namespace sim_env {
+namespace benchmark {
+    struct Options {
+        // thread counts to sweep over in multi-threaded benchmarks
+        std::vector<unsigned int> thread_counts;
+        // number of times each measurement is repeated, the fastest repetition is reported
+        unsigned int repetitions;
+    };
+
+    /**
+         * Calls fn repetitions times and returns the duration of the fastest call in seconds.
+         */
+    template <typename Function>
+    double measure(Function fn, unsigned int repetitions)
+    {
+        double best = std::numeric_limits<double>::max();
+        for (unsigned int r = 0; r < std::max(repetitions, 1u); ++r) {
+            auto start = std::chrono::steady_clock::now();
+            fn();
+            std::chrono::duration<double> duration = std::chrono::steady_clock::now() - start;
+            best = std::min(best, duration.count());
+        }
+        return best;
+    }
+
+    /**
+         * Prints a headline for a group of measurements.
+         */
+    void printHeader(const std::string& title);
+
+    // entry points of the individual benchmarks
+    void runLayoutBenchmark(const Options& options);
+    void runDistanceTransformBenchmark(const Options& options);
+    void runConcurrentGridBenchmark(const Options& options);
+    void runRayCastingBenchmark(const Options& options);
+    void runVoxelizationBenchmark(const Options& options);
+}
+}
+
+#endif //SIM_ENV_BENCHMARK_H
@@ -0,0 +1,82 @@
+//
+// Measures the throughput of concurrent updates of a ConcurrentGrid3D under contention.
+//
+#include "Benchmark.h"
+#include <cstdio>
+#include <random>
+#include <sim_env/grid/ConcurrentGrid3D.h>
+#include <sim_env/utils/ParallelUtils.h>
+
+using namespace sim_env::grid;
+
+namespace {
+const size_t GRID_SIZE = 128;
+const size_t OPS_PER_THREAD = 1 << 20;
+// updateBrick visits all cells of a brick, hence fewer operations are executed
+const size_t BRICK_OPS_PER_THREAD = 1 << 12;
+
+// cell indices per thread, either uniformly distributed over the grid or within one 8^3 cluster
+std::vector<std::vector<UnsignedIndex>> createIndices(unsigned int num_threads, size_t num_ops, bool b_clustered)
+{
+    std::vector<std::vector<UnsignedIndex>> indices(num_threads);
+    std::mt19937 generator(0);
+    const size_t range = b_clustered ? 8 : GRID_SIZE;
+    const size_t offset = b_clustered ? GRID_SIZE / 2 : 0;
+    for (auto& thread_indices : indices) {
+        thread_indices.resize(num_ops);
+        for (auto& idx : thread_indices) {
+            idx.set(offset + generator() % range, offset + generator() % range, offset + generator() % range);
+        }
+    }
+    return indices;
+}
+
+template <typename Operation>
+void benchmarkOperation(const char* name, size_t num_ops, Operation op, const sim_env::benchmark::Options& options)
+{
+    for (int clustered = 0; clustered < 2; ++clustered) {
+        std::printf("%-12s %-9s", name, clustered ? "clustered" : "random");
+        for (unsigned int num_threads : options.thread_counts) {
+            Grid3D<float> grid(GRID_SIZE, GRID_SIZE, GRID_SIZE, 0.0f);
+            ConcurrentGrid3D<float> concurrent_grid(grid);
+            auto indices = createIndices(num_threads, num_ops, clustered != 0);
+            double duration = sim_env::benchmark::measure([&]() {
+                sim_env::utils::parallel::parallelFor(0, num_threads, [&](size_t begin, size_t end) {
+                    for (size_t t = begin; t < end; ++t) {
+                        for (auto& idx : indices[t]) {
+                            op(concurrent_grid, idx);
+                        }
+                    }
+                },
+                    num_threads, 1);
+            },
+                options.repetitions);
+            std::printf("  %2ut %8.2f Mops/s", num_threads, 1e-6 * num_threads * num_ops / duration);
+        }
+        std::printf("\n");
+    }
+}
+}
+
+void sim_env::benchmark::runConcurrentGridBenchmark(const Options& options)
+{
+    printHeader("ConcurrentGrid3D: updates of a 128^3 float grid (8^3 bricks, 1024 stripes, "
+                "one updateBrick operation visits a whole brick)");
+    benchmarkOperation("atomicAdd", OPS_PER_THREAD, [](ConcurrentGrid3D<float>& grid, const UnsignedIndex& idx) {
+        grid.atomicAdd(idx, 1.0f);
+    },
+        options);
+    benchmarkOperation("atomicMax", OPS_PER_THREAD, [](ConcurrentGrid3D<float>& grid, const UnsignedIndex& idx) {
+        grid.atomicMax(idx, (float)idx.ix);
+    },
+        options);
+    benchmarkOperation("update", OPS_PER_THREAD, [](ConcurrentGrid3D<float>& grid, const UnsignedIndex& idx) {
+        grid.update(idx, [](float& value) { value += 1.0f; });
+    },
+        options);
+    benchmarkOperation("updateBrick", BRICK_OPS_PER_THREAD,
+        [](ConcurrentGrid3D<float>& grid, const UnsignedIndex& idx) {
+            grid.updateBrick(idx, [](const UnsignedIndex&, float& value) { value += 1.0f; });
+        },
+        options);
+}
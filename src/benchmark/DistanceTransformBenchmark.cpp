@@ -0,0 +1,63 @@
+//
+// Measures the time of computing a signed distance field of a 256^3 grid.
+//
+#include "Benchmark.h"
+#include <algorithm>
+#include <cstdio>
+#include <random>
+#include <sim_env/grid/DistanceTransform.h>
+
+using namespace sim_env::grid;
+
+namespace {
+const size_t GRID_SIZE = 256;
+const unsigned int NUM_SPHERES = 200;
+}
+
+void sim_env::benchmark::runDistanceTransformBenchmark(const Options& options)
+{
+    printHeader("computeSignedDistanceField: 256^3 grid with random spheres");
+    const float cell_size = 1.0f / GRID_SIZE;
+    // cell centers lie at (i + 0.5) * cell_size, hence the box ends half a cell before 1
+    VoxelGrid<float, unsigned char> grid(Eigen::Vector3f::Zero(), Eigen::Vector3f::Constant(1.0f - 0.5f * cell_size),
+        cell_size);
+    std::fill(grid.begin(), grid.end(), 0);
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> coordinate_distribution(0.0f, 1.0f);
+    std::uniform_real_distribution<float> radius_distribution(0.01f, 0.08f);
+    Eigen::Vector3f position;
+    for (unsigned int s = 0; s < NUM_SPHERES; ++s) {
+        Eigen::Vector3f center(coordinate_distribution(generator), coordinate_distribution(generator),
+            coordinate_distribution(generator));
+        float radius = radius_distribution(generator);
+        // only visit the cells within the bounding box of the sphere
+        size_t begin[3], end[3];
+        for (unsigned int d = 0; d < 3; ++d) {
+            begin[d] = (size_t)std::max(0.0f, (center[d] - radius) / cell_size);
+            end[d] = std::min(GRID_SIZE, (size_t)std::max(0.0f, (center[d] + radius) / cell_size + 1.0f));
+        }
+        for (size_t z = begin[2]; z < end[2]; ++z) {
+            for (size_t y = begin[1]; y < end[1]; ++y) {
+                for (size_t x = begin[0]; x < end[0]; ++x) {
+                    grid.getCellPosition(UnsignedIndex(x, y, z), position, true);
+                    if ((position - center).squaredNorm() < radius * radius) {
+                        grid(x, y, z) = 1;
+                    }
+                }
+            }
+        }
+    }
+    size_t num_occupied = std::count(grid.begin(), grid.end(), 1);
+    VoxelGrid<float, float> distance_field(Eigen::Vector3f::Zero(),
+        Eigen::Vector3f::Constant(1.0f - 0.5f * cell_size), cell_size);
+    std::printf("%zu x %zu x %zu cells, %.1f%% occupied\n", grid.getXSize(), grid.getYSize(), grid.getZSize(),
+        100.0 * num_occupied / (grid.getXSize() * grid.getYSize() * grid.getZSize()));
+    auto is_occupied = [](const unsigned char& value) { return value != 0; };
+    for (unsigned int num_threads : options.thread_counts) {
+        double duration = measure([&]() {
+            computeSignedDistanceField(grid, is_occupied, distance_field, num_threads);
+        },
+            options.repetitions);
+        std::printf("  %2u threads %8.1f ms\n", num_threads, 1e3 * duration);
+    }
+}
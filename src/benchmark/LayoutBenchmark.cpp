@@ -0,0 +1,81 @@
+//
+// Compares the memory layouts of Grid3D on box-neighborhood queries.
+//
+#include "Benchmark.h"
+#include <cstdio>
+#include <random>
+#include <sim_env/Grid.h>
+
+using namespace sim_env::grid;
+
+namespace {
+// keeps the compiler from optimizing the queries away
+volatile float g_sink;
+
+template <typename Layout>
+void benchmarkLayout(const char* layout_name, size_t x_size, size_t y_size, size_t z_size,
+    const sim_env::benchmark::Options& options)
+{
+    Grid3D<float, Layout> grid(x_size, y_size, z_size, 0.0f);
+    std::mt19937 generator(0);
+    std::uniform_real_distribution<float> value_distribution(0.0f, 1.0f);
+    for (size_t z = 0; z < z_size; ++z) {
+        for (size_t y = 0; y < y_size; ++y) {
+            for (size_t x = 0; x < x_size; ++x) {
+                grid(x, y, z) = value_distribution(generator);
+            }
+        }
+    }
+    const size_t num_cells = x_size * y_size * z_size;
+    // sum over the 3x3x3 box of every cell, visiting the cells in index order
+    double sweep_time = sim_env::benchmark::measure([&]() {
+        float sum = 0.0f;
+        UnsignedIndex idx;
+        for (idx.iz = 0; idx.iz < z_size; ++idx.iz) {
+            for (idx.iy = 0; idx.iy < y_size; ++idx.iy) {
+                for (idx.ix = 0; idx.ix < x_size; ++idx.ix) {
+                    grid.forEachNeighbor(idx, 1, 1, 1, [&sum](const UnsignedIndex&, const float& value) {
+                        sum += value;
+                    });
+                }
+            }
+        }
+        g_sink = sum;
+    },
+        options.repetitions);
+    // sum over 9x9x9 boxes at random cells
+    const size_t num_queries = 20000;
+    std::vector<UnsignedIndex> centers(num_queries);
+    for (auto& center : centers) {
+        center.set(generator() % x_size, generator() % y_size, generator() % z_size);
+    }
+    double random_time = sim_env::benchmark::measure([&]() {
+        float sum = 0.0f;
+        for (auto& center : centers) {
+            grid.forEachNeighbor(center, 4, 4, 4, [&sum](const UnsignedIndex&, const float& value) {
+                sum += value;
+            });
+        }
+        g_sink = sum;
+    },
+        options.repetitions);
+    std::printf("%4zu x %4zu x %4zu  %-10s  padding %5.2fx  sweep r=1 %7.2f ns/cell  random r=4 %8.1f ns/box\n",
+        x_size, y_size, z_size, layout_name, (double)grid.getStorageSize() / num_cells, 1e9 * sweep_time / num_cells,
+        1e9 * random_time / num_queries);
+}
+
+void benchmarkLayouts(size_t x_size, size_t y_size, size_t z_size, const sim_env::benchmark::Options& options)
+{
+    benchmarkLayout<RowMajorLayout>("RowMajor", x_size, y_size, z_size, options);
+    benchmarkLayout<TiledLayout<8>>("Tiled<8>", x_size, y_size, z_size, options);
+    benchmarkLayout<MortonLayout>("Morton", x_size, y_size, z_size, options);
+}
+}
+
+void sim_env::benchmark::runLayoutBenchmark(const Options& options)
+{
+    printHeader("Grid3D layouts: box-neighborhood queries (single thread)");
+    benchmarkLayouts(128, 128, 128, options);
+    benchmarkLayouts(256, 256, 32, options);
+    benchmarkLayouts(200, 120, 60, options);
+}
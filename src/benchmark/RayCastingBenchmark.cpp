@@ -0,0 +1,70 @@
+//
+// Measures the throughput of batched ray casting through a voxel grid.
+//
+#include "Benchmark.h"
+#include <cmath>
+#include <cstdio>
+#include <sim_env/grid/RayCasting.h>
+
+using namespace sim_env::grid;
+
+namespace {
+// image size of the simulated depth sensor
+const long IMAGE_WIDTH = 640;
+const long IMAGE_HEIGHT = 480;
+
+void benchmarkRays(const char* name, const VoxelGrid<float, float>& grid, const Eigen::Vector3f& origin,
+    const Eigen::Matrix3Xf& directions, const sim_env::benchmark::Options& options)
+{
+    std::vector<RayHit<float>> hits;
+    Eigen::Matrix3Xf origins = origin;
+    auto is_hit = [](const float& value) { return value > 0.5f; };
+    std::printf("%-24s", name);
+    for (unsigned int num_threads : options.thread_counts) {
+        double duration = sim_env::benchmark::measure([&]() {
+            castRays(grid, origins, directions, 8.0f, is_hit, hits, num_threads);
+        },
+            options.repetitions);
+        std::printf("  %2ut %7.2f Mrays/s", num_threads, 1e-6 * directions.cols() / duration);
+    }
+    size_t num_hits = 0;
+    for (auto& hit : hits) {
+        num_hits += hit.hit ? 1 : 0;
+    }
+    std::printf("  (%.0f%% hits)\n", 100.0 * num_hits / hits.size());
+}
+}
+
+void sim_env::benchmark::runRayCastingBenchmark(const Options& options)
+{
+    printHeader("castRays: 640x480 rays through a 4m^3 grid with 2.5cm cells");
+    VoxelGrid<float, float> grid(Eigen::Vector3f::Zero(), Eigen::Vector3f::Constant(4.0f), 0.025f);
+    // a floor and a sphere in the center of the grid
+    const Eigen::Vector3f center(2.0f, 2.0f, 1.0f);
+    Eigen::Vector3f position;
+    for (size_t z = 0; z < grid.getZSize(); ++z) {
+        for (size_t y = 0; y < grid.getYSize(); ++y) {
+            for (size_t x = 0; x < grid.getXSize(); ++x) {
+                grid.getCellPosition(UnsignedIndex(x, y, z), position, true);
+                bool b_occupied = position.z() < 0.1f or (position - center).norm() < 0.8f;
+                grid(x, y, z) = b_occupied ? 1.0f : 0.0f;
+            }
+        }
+    }
+    // pinhole sensor in a corner of the grid that looks at the sphere
+    const Eigen::Vector3f origin(0.2f, 0.2f, 2.0f);
+    const Eigen::Vector3f forward = (center - origin).normalized();
+    const Eigen::Vector3f right = forward.cross(Eigen::Vector3f::UnitZ()).normalized();
+    const Eigen::Vector3f up = right.cross(forward);
+    Eigen::Matrix3Xf directions(3, IMAGE_WIDTH * IMAGE_HEIGHT);
+    for (long v = 0; v < IMAGE_HEIGHT; ++v) {
+        for (long u = 0; u < IMAGE_WIDTH; ++u) {
+            float du = (u - 0.5f * IMAGE_WIDTH) / IMAGE_WIDTH;
+            float dv = (v - 0.5f * IMAGE_HEIGHT) / IMAGE_WIDTH;
+            directions.col(v * IMAGE_WIDTH + u) = forward + 1.2f * du * right + 1.2f * dv * up;
+        }
+    }
+    benchmarkRays("sensor view", grid, origin, directions, options);
+    // the opposite view from the other corner, most rays pass above the sphere up to the boundary of the grid
+    benchmarkRays("reverse view", grid, Eigen::Vector3f(3.8f, 3.8f, 2.0f), -directions, options);
+}
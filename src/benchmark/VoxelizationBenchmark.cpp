@@ -0,0 +1,61 @@
+//
+// Measures the throughput of voxelizing a single large triangle mesh.
+//
+#include "Benchmark.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdio>
+#include <sim_env/grid/Voxelization.h>
+
+using namespace sim_env::grid;
+
+namespace {
+// the sphere is tessellated into 2 * NUM_RINGS * NUM_SEGMENTS triangles
+const unsigned int NUM_RINGS = 256;
+const unsigned int NUM_SEGMENTS = 256;
+
+// a uv-sphere with the given radius around the origin
+sim_env::Geometry createSphere(float radius)
+{
+    sim_env::Geometry sphere;
+    sphere.is_polygon = false;
+    for (unsigned int r = 0; r <= NUM_RINGS; ++r) {
+        float theta = (float)M_PI * r / NUM_RINGS;
+        for (unsigned int s = 0; s < NUM_SEGMENTS; ++s) {
+            float phi = 2.0f * (float)M_PI * s / NUM_SEGMENTS;
+            sphere.vertices.push_back(radius * Eigen::Vector3f(std::sin(theta) * std::cos(phi),
+                                                   std::sin(theta) * std::sin(phi), std::cos(theta)));
+        }
+    }
+    for (unsigned int r = 0; r < NUM_RINGS; ++r) {
+        for (unsigned int s = 0; s < NUM_SEGMENTS; ++s) {
+            unsigned int a = r * NUM_SEGMENTS + s;
+            unsigned int b = r * NUM_SEGMENTS + (s + 1) % NUM_SEGMENTS;
+            sphere.triangles.push_back(std::make_tuple(a, b, a + NUM_SEGMENTS));
+            sphere.triangles.push_back(std::make_tuple(b, b + NUM_SEGMENTS, a + NUM_SEGMENTS));
+        }
+    }
+    return sphere;
+}
+}
+
+void sim_env::benchmark::runVoxelizationBenchmark(const Options& options)
+{
+    printHeader("voxelize: one sphere mesh with 131k triangles into a 2m^3 grid with 1cm cells");
+    VoxelGrid<float, unsigned char> grid(Eigen::Vector3f::Constant(-1.0f), Eigen::Vector3f::Constant(1.0f), 0.01f);
+    std::vector<Geometry> geometries(1, createSphere(0.9f));
+    std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f>> transforms(1,
+        Eigen::Affine3f::Identity());
+    const size_t num_triangles = geometries[0].triangles.size();
+    size_t num_written = 0;
+    for (unsigned int num_threads : options.thread_counts) {
+        double duration = measure([&]() {
+            num_written = voxelize(geometries, transforms, grid, (unsigned char)1, num_threads);
+        },
+            options.repetitions);
+        std::printf("  %2u threads %8.1f ms %8.2f Mtriangles/s\n", num_threads, 1e3 * duration,
+            1e-6 * num_triangles / duration);
+    }
+    size_t num_occupied = std::count(grid.begin(), grid.end(), 1);
+    std::printf("%zu cells occupied, %zu cells written\n", num_occupied, num_written);
+}
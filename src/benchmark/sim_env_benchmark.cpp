@@ -0,0 +1,93 @@
+//
+// Benchmarks of performance critical parts of sim_env.
+// Usage: sim_env_benchmark [--threads 1,2,4] [--repetitions n] [benchmark ...]
+// Without benchmark names all benchmarks are run.
+//
+#include "Benchmark.h"
+#include <cstdlib>
+#include <iostream>
+#include <sstream>
+#include <thread>
+
+using namespace sim_env::benchmark;
+
+namespace {
+struct Entry {
+    const char* name;
+    void (*run)(const Options&);
+};
+
+const Entry BENCHMARKS[] = {
+    { "layout", runLayoutBenchmark },
+    { "concurrent_grid", runConcurrentGridBenchmark },
+    { "ray_casting", runRayCastingBenchmark },
+    { "distance_transform", runDistanceTransformBenchmark },
+    { "voxelization", runVoxelizationBenchmark },
+};
+
+std::vector<unsigned int> parseThreadCounts(const std::string& arg)
+{
+    std::vector<unsigned int> thread_counts;
+    std::stringstream stream(arg);
+    std::string item;
+    while (std::getline(stream, item, ',')) {
+        thread_counts.push_back((unsigned int)std::max(1, std::atoi(item.c_str())));
+    }
+    return thread_counts;
+}
+
+std::vector<unsigned int> defaultThreadCounts()
+{
+    unsigned int max_threads = std::max(std::thread::hardware_concurrency(), 1u);
+    std::vector<unsigned int> thread_counts;
+    for (unsigned int n = 1; n < max_threads; n *= 2) {
+        thread_counts.push_back(n);
+    }
+    thread_counts.push_back(max_threads);
+    return thread_counts;
+}
+}
+
+void sim_env::benchmark::printHeader(const std::string& title)
+{
+    std::cout << "\n=== " << title << " ===" << std::endl;
+}
+
+int main(int argc, char** argv)
+{
+    Options options;
+    options.thread_counts = defaultThreadCounts();
+    options.repetitions = 3;
+    std::vector<std::string> names;
+    for (int i = 1; i < argc; ++i) {
+        std::string arg(argv[i]);
+        if (arg == "--threads" and i + 1 < argc) {
+            options.thread_counts = parseThreadCounts(argv[++i]);
+        } else if (arg == "--repetitions" and i + 1 < argc) {
+            options.repetitions = (unsigned int)std::max(1, std::atoi(argv[++i]));
+        } else {
+            names.push_back(arg);
+        }
+    }
+    std::cout << "hardware threads: " << std::thread::hardware_concurrency() << std::endl;
+    for (auto& name : names) {
+        bool b_known = false;
+        for (auto& entry : BENCHMARKS) {
+            b_known = b_known or name == entry.name;
+        }
+        if (not b_known) {
+            std::cerr << "Unknown benchmark " << name << ". Available benchmarks:";
+            for (auto& entry : BENCHMARKS) {
+                std::cerr << " " << entry.name;
+            }
+            std::cerr << std::endl;
+            return 1;
+        }
+    }
+    for (auto& entry : BENCHMARKS) {
+        if (names.empty() or std::find(names.begin(), names.end(), entry.name) != names.end()) {
+            entry.run(options);
+        }
+    }
+    return 0;
+}
@@ -0,0 +1,157 @@
+//
+// Parallel execution of rollouts on pooled worlds.
+//
+#include "sim_env/RolloutExecutor.h"
+#include "sim_env/utils/ParallelUtils.h"
+#include <algorithm>
+#include <atomic>
+#include <chrono>
+#include <stdexcept>
+
+using namespace sim_env;
+
+namespace {
+// input of the action that is currently executed, shared with the control callback of the robot
+struct CurrentInput {
+    Eigen::VectorXf input;
+};
+
+// removes the controller of a robot when going out of scope, so that pooled worlds are returned without it
+struct ControllerGuard {
+    RobotPtr robot;
+    explicit ControllerGuard(RobotPtr lrobot)
+        : robot(lrobot)
+    {
+    }
+    ~ControllerGuard()
+    {
+        robot->setController(Robot::ControlCallback());
+    }
+};
+}
+
+sim_env::RolloutExecutor::RolloutExecutor(WorldPoolPtr pool, const std::string& robot_name, InputMode mode,
+    ControllerFactory controller_factory)
+    : _pool(pool)
+    , _robot_name(robot_name)
+    , _mode(mode)
+    , _controller_factory(controller_factory)
+    , _record_contacts(true)
+    , _last_rollouts_per_second(0.0f)
+{
+    if (not _pool) {
+        throw std::invalid_argument("[sim_env::RolloutExecutor::RolloutExecutor] The pool must not be null.");
+    }
+    if (_mode == InputMode::Target and not _controller_factory) {
+        throw std::invalid_argument("[sim_env::RolloutExecutor::RolloutExecutor] "
+                                    "A controller factory is required for target inputs.");
+    }
+}
+
+sim_env::RolloutExecutor::~RolloutExecutor() = default;
+
+void sim_env::RolloutExecutor::setCostFunction(CostFunction cost_fn)
+{
+    _cost_fn = cost_fn;
+}
+
+void sim_env::RolloutExecutor::setRecordContacts(bool b_record)
+{
+    _record_contacts = b_record;
+}
+
+WorldPoolPtr sim_env::RolloutExecutor::getPool() const
+{
+    return _pool;
+}
+
+void sim_env::RolloutExecutor::execute(const std::vector<ActionSequence>& sequences,
+    std::vector<RolloutResult>& results, unsigned int num_threads)
+{
+    results.resize(sequences.size());
+    // more threads than worlds would only block on the pool
+    unsigned int num_worlds = std::max(_pool->getNumWorlds(), 1u);
+    num_threads = num_threads == 0 ? num_worlds : std::min(num_threads, num_worlds);
+    auto start_time = std::chrono::steady_clock::now();
+    // Each worker leases a single world and pulls the next sequence from a shared counter until all sequences
+    // are taken. Hence, idle workers pick up the remaining rollouts one at a time, no matter how uneven
+    // their lengths are, and each worker leases a world only once.
+    std::atomic<size_t> next_sequence(0);
+    utils::parallel::parallelFor(0, num_threads, [&](size_t, size_t) {
+        if (next_sequence >= sequences.size()) {
+            return;
+        }
+        WorldPool::Lease lease = _pool->lease();
+        WorldPtr world = lease.getWorld();
+        // the leased world is in the master state, restore it before every further rollout
+        WorldState start_state;
+        world->getWorldState(start_state);
+        bool b_first = true;
+        size_t i;
+        while ((i = next_sequence++) < sequences.size()) {
+            if (not b_first and not world->setWorldState(start_state)) {
+                throw std::runtime_error("[sim_env::RolloutExecutor::execute] Could not reset a pooled world "
+                                         "to the start state.");
+            }
+            b_first = false;
+            runRollout(world, sequences[i], results[i]);
+        }
+    },
+        num_threads, 1);
+    std::chrono::duration<float> duration = std::chrono::steady_clock::now() - start_time;
+    _last_rollouts_per_second = duration.count() > 0.0f ? sequences.size() / duration.count() : 0.0f;
+}
+
+void sim_env::RolloutExecutor::execute(const ActionSequence& sequence, RolloutResult& result)
+{
+    WorldPool::Lease lease = _pool->lease();
+    runRollout(lease.getWorld(), sequence, result);
+}
+
+float sim_env::RolloutExecutor::getLastRolloutsPerSecond() const
+{
+    return _last_rollouts_per_second;
+}
+
+void sim_env::RolloutExecutor::runRollout(WorldPtr world, const ActionSequence& sequence, RolloutResult& result)
+{
+    std::lock_guard<std::recursive_mutex> world_lock(world->getMutex());
+    RobotPtr robot = world->getRobot(_robot_name);
+    if (not robot) {
+        throw std::runtime_error("[sim_env::RolloutExecutor::runRollout] There is no robot " + _robot_name + ".");
+    }
+    auto current_input = std::make_shared<CurrentInput>();
+    RobotControllerPtr controller;
+    ControllerGuard controller_guard(robot);
+    if (_mode == InputMode::Target) {
+        controller = _controller_factory(robot);
+        robot->setController([controller](const Eigen::VectorXf& positions, const Eigen::VectorXf& velocities,
+                                 float timestep, RobotConstPtr robot, Eigen::VectorXf& output) {
+            return controller->control(positions, velocities, timestep, robot, output);
+        });
+    } else {
+        robot->setController([current_input](const Eigen::VectorXf&, const Eigen::VectorXf&, float,
+                                 RobotConstPtr, Eigen::VectorXf& output) {
+            output = current_input->input;
+            return true;
+        });
+    }
+    result.contacts.clear();
+    std::vector<Contact> step_contacts;
+    for (auto& action : sequence) {
+        if (controller) {
+            controller->setTarget(action.input);
+        } else {
+            current_input->input = action.input;
+        }
+        if (_record_contacts) {
+            step_contacts.clear();
+            world->stepPhysics(step_contacts, (int)action.num_steps);
+            result.contacts.insert(result.contacts.end(), step_contacts.begin(), step_contacts.end());
+        } else {
+            world->stepPhysics((int)action.num_steps);
+        }
+    }
+    world->getWorldState(result.final_state);
+    result.cost = _cost_fn ? _cost_fn(world, sequence, result) : 0.0f;
+}
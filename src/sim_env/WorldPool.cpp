@@ -0,0 +1,235 @@
+//
+// Pool of pre-cloned worlds.
+//
+#include "sim_env/WorldPool.h"
+#include <stdexcept>
+
+using namespace sim_env;
+
+/************************************* WorldPool::Lease **************************************/
+sim_env::WorldPool::Lease::Lease()
+    : _pool(nullptr)
+{
+}
+
+sim_env::WorldPool::Lease::Lease(WorldPool* pool, WorldPtr world)
+    : _pool(pool)
+    , _world(world)
+{
+}
+
+sim_env::WorldPool::Lease::Lease(Lease&& other)
+    : _pool(other._pool)
+    , _world(std::move(other._world))
+{
+    other._pool = nullptr;
+    other._world.reset();
+}
+
+WorldPool::Lease& sim_env::WorldPool::Lease::operator=(Lease&& other)
+{
+    if (this != &other) {
+        release();
+        _pool = other._pool;
+        _world = std::move(other._world);
+        other._pool = nullptr;
+        other._world.reset();
+    }
+    return *this;
+}
+
+sim_env::WorldPool::Lease::~Lease()
+{
+    release();
+}
+
+WorldPtr sim_env::WorldPool::Lease::getWorld() const
+{
+    return _world;
+}
+
+World* sim_env::WorldPool::Lease::operator->() const
+{
+    return _world.get();
+}
+
+sim_env::WorldPool::Lease::operator bool() const
+{
+    return _world != nullptr;
+}
+
+void sim_env::WorldPool::Lease::release()
+{
+    if (_pool and _world) {
+        _pool->release(_world);
+    }
+    _pool = nullptr;
+    _world.reset();
+}
+
+/************************************* WorldPool **************************************/
+sim_env::WorldPool::WorldPool(WorldPtr master, unsigned int num_worlds)
+    : _master(master)
+    , _master_version(0)
+{
+    if (not _master) {
+        throw std::invalid_argument("[sim_env::WorldPool::WorldPool] The master world must not be null.");
+    }
+    updateMasterState();
+    reserve(num_worlds);
+}
+
+sim_env::WorldPool::~WorldPool() = default;
+
+WorldPtr sim_env::WorldPool::acquire()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    _available_condition.wait(lock, [this] {
+        for (auto& pooled_world : _worlds) {
+            if (pooled_world->available) {
+                return true;
+            }
+        }
+        return false;
+    });
+    return checkout(lock);
+}
+
+WorldPtr sim_env::WorldPool::tryAcquire()
+{
+    std::unique_lock<std::mutex> lock(_mutex);
+    return checkout(lock);
+}
+
+WorldPool::Lease sim_env::WorldPool::lease()
+{
+    return Lease(this, acquire());
+}
+
+void sim_env::WorldPool::release(WorldPtr world)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        bool found = false;
+        for (auto& pooled_world : _worlds) {
+            if (pooled_world->world == world and not pooled_world->available) {
+                pooled_world->available = true;
+                found = true;
+                break;
+            }
+        }
+        if (not found) {
+            throw std::invalid_argument("[sim_env::WorldPool::release] The given world was not acquired from this pool.");
+        }
+    }
+    _available_condition.notify_one();
+}
+
+void sim_env::WorldPool::reserve(unsigned int num_worlds)
+{
+    while (getNumWorlds() < num_worlds) {
+        // clone without holding the lock, so that other threads can continue to use the pool
+        PooledWorldPtr pooled_world = createWorld();
+        {
+            std::lock_guard<std::mutex> lock(_mutex);
+            _worlds.push_back(pooled_world);
+        }
+        _available_condition.notify_one();
+    }
+}
+
+void sim_env::WorldPool::updateMasterState()
+{
+    WorldState state;
+    {
+        std::lock_guard<std::recursive_mutex> world_lock(_master->getMutex());
+        _master->getWorldState(state);
+    }
+    setMasterState(state);
+}
+
+void sim_env::WorldPool::setMasterState(const WorldState& state)
+{
+    auto master_state = std::make_shared<const WorldState>(state);
+    std::lock_guard<std::mutex> lock(_mutex);
+    _master_state = master_state;
+    ++_master_version;
+}
+
+WorldState sim_env::WorldPool::getMasterState() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return *_master_state;
+}
+
+WorldPtr sim_env::WorldPool::getMasterWorld() const
+{
+    return _master;
+}
+
+unsigned int sim_env::WorldPool::getNumWorlds() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    return (unsigned int)_worlds.size();
+}
+
+unsigned int sim_env::WorldPool::getNumAvailable() const
+{
+    std::lock_guard<std::mutex> lock(_mutex);
+    unsigned int num_available = 0;
+    for (auto& pooled_world : _worlds) {
+        num_available += pooled_world->available ? 1 : 0;
+    }
+    return num_available;
+}
+
+WorldPtr sim_env::WorldPool::checkout(std::unique_lock<std::mutex>& lock)
+{
+    PooledWorldPtr pooled_world;
+    for (auto& candidate : _worlds) {
+        if (candidate->available) {
+            pooled_world = candidate;
+            break;
+        }
+    }
+    if (not pooled_world) {
+        return nullptr;
+    }
+    pooled_world->available = false;
+    std::shared_ptr<const WorldState> master_state = _master_state;
+    size_t master_version = _master_version;
+    // the world is now exclusively owned by this thread, synchronize it without holding the lock
+    lock.unlock();
+    try {
+        if (pooled_world->sync_version != master_version) {
+            // assigning a map of the same keys reuses its nodes
+            pooled_world->sync_state = *master_state;
+            pooled_world->sync_version = master_version;
+        }
+        std::lock_guard<std::recursive_mutex> world_lock(pooled_world->world->getMutex());
+        if (not pooled_world->world->setWorldState(pooled_world->sync_state)) {
+            throw std::runtime_error("[sim_env::WorldPool::checkout] Could not synchronize a pooled world "
+                                     "to the master state.");
+        }
+    } catch (...) {
+        lock.lock();
+        pooled_world->available = true;
+        lock.unlock();
+        _available_condition.notify_one();
+        throw;
+    }
+    return pooled_world->world;
+}
+
+WorldPool::PooledWorldPtr sim_env::WorldPool::createWorld()
+{
+    auto pooled_world = std::make_shared<PooledWorld>();
+    {
+        std::lock_guard<std::recursive_mutex> world_lock(_master->getMutex());
+        pooled_world->world = _master->clone();
+    }
+    pooled_world->available = true;
+    // force a synchronization on first use
+    pooled_world->sync_version = (size_t)-1;
+    return pooled_world;
+}
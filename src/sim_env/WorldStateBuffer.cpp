@@ -0,0 +1,433 @@
+//
+// Flat, contiguous representation of world states.
+//
+#include "sim_env/WorldStateBuffer.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace sim_env;
+
+namespace {
+bool compareEntries(const WorldStateLayout::ObjectEntry& a, const WorldStateLayout::ObjectEntry& b)
+{
+    return a.name < b.name;
+}
+
+// returns whether state contains exactly the objects of layout, in the same order
+bool hasObjects(const WorldState& state, const WorldStateLayout& layout)
+{
+    if (state.size() != layout.getNumObjects()) {
+        return false;
+    }
+    auto entry_iter = layout.getObjectEntries().begin();
+    for (auto& state_pair : state) {
+        if (state_pair.first != entry_iter->name) {
+            return false;
+        }
+        ++entry_iter;
+    }
+    return true;
+}
+}
+
+const unsigned int sim_env::WorldStateLayout::POSE_SIZE;
+
+/************************************* WorldStateLayout **************************************/
+sim_env::WorldStateLayout::WorldStateLayout()
+    : _size(0)
+{
+}
+
+sim_env::WorldStateLayout::WorldStateLayout(const WorldState& state)
+{
+    _entries.reserve(state.size());
+    for (auto& state_pair : state) {
+        const ObjectState& object_state = state_pair.second;
+        if (object_state.dof_positions.size() != object_state.dof_velocities.size()) {
+            throw std::invalid_argument("[sim_env::WorldStateLayout::WorldStateLayout] "
+                                        "The state of object "
+                + state_pair.first + " has different numbers of DOF positions and velocities.");
+        }
+        ObjectEntry entry;
+        entry.name = state_pair.first;
+        entry.num_dofs = (unsigned int)object_state.dof_positions.size();
+        entry.active_dofs = object_state.active_dofs;
+        _entries.push_back(entry);
+    }
+    // a map is already sorted by name
+    computeOffsets();
+}
+
+sim_env::WorldStateLayout::WorldStateLayout(WorldConstPtr world)
+{
+    std::vector<ObjectConstPtr> objects;
+    world->getObjects(objects, false);
+    _entries.reserve(objects.size());
+    for (auto& object : objects) {
+        ObjectEntry entry;
+        entry.name = object->getName();
+        entry.num_dofs = object->getNumDOFs();
+        entry.active_dofs = object->getActiveDOFs();
+        _entries.push_back(entry);
+    }
+    std::sort(_entries.begin(), _entries.end(), compareEntries);
+    computeOffsets();
+}
+
+sim_env::WorldStateLayout::~WorldStateLayout() = default;
+
+size_t sim_env::WorldStateLayout::getSize() const
+{
+    return _size;
+}
+
+size_t sim_env::WorldStateLayout::getNumObjects() const
+{
+    return _entries.size();
+}
+
+const WorldStateLayout::ObjectEntry& sim_env::WorldStateLayout::getObjectEntry(size_t object_idx) const
+{
+    return _entries.at(object_idx);
+}
+
+const std::vector<WorldStateLayout::ObjectEntry>& sim_env::WorldStateLayout::getObjectEntries() const
+{
+    return _entries;
+}
+
+int sim_env::WorldStateLayout::getObjectIndex(const std::string& name) const
+{
+    ObjectEntry key;
+    key.name = name;
+    auto iter = std::lower_bound(_entries.begin(), _entries.end(), key, compareEntries);
+    if (iter == _entries.end() or iter->name != name) {
+        return -1;
+    }
+    return (int)(iter - _entries.begin());
+}
+
+bool sim_env::WorldStateLayout::isCompatible(const WorldState& state) const
+{
+    if (not hasObjects(state, *this)) {
+        return false;
+    }
+    auto entry_iter = _entries.begin();
+    for (auto& state_pair : state) {
+        if (state_pair.second.dof_positions.size() != entry_iter->num_dofs
+            or state_pair.second.dof_velocities.size() != entry_iter->num_dofs) {
+            return false;
+        }
+        ++entry_iter;
+    }
+    return true;
+}
+
+bool sim_env::WorldStateLayout::isCompatible(const WorldStateLayout& other) const
+{
+    if (this == &other) {
+        return true;
+    }
+    if (_size != other._size or _entries.size() != other._entries.size()) {
+        return false;
+    }
+    for (size_t i = 0; i < _entries.size(); ++i) {
+        if (_entries[i].offset != other._entries[i].offset or _entries[i].num_dofs != other._entries[i].num_dofs
+            or _entries[i].name != other._entries[i].name) {
+            return false;
+        }
+    }
+    return true;
+}
+
+void sim_env::WorldStateLayout::computeOffsets()
+{
+    _size = 0;
+    for (auto& entry : _entries) {
+        entry.offset = _size;
+        _size += entry.getSize();
+    }
+}
+
+/************************************* WorldStateBuffer **************************************/
+sim_env::WorldStateBuffer::WorldStateBuffer() = default;
+
+sim_env::WorldStateBuffer::WorldStateBuffer(WorldStateLayoutConstPtr layout)
+{
+    setLayout(layout);
+}
+
+sim_env::WorldStateBuffer::~WorldStateBuffer() = default;
+
+void sim_env::WorldStateBuffer::setLayout(WorldStateLayoutConstPtr layout)
+{
+    _layout = layout;
+    // resize is a no-op if the size does not change
+    _values.resize(_layout ? _layout->getSize() : 0);
+}
+
+WorldStateLayoutConstPtr sim_env::WorldStateBuffer::getLayout() const
+{
+    return _layout;
+}
+
+size_t sim_env::WorldStateBuffer::size() const
+{
+    return _values.size();
+}
+
+float* sim_env::WorldStateBuffer::data()
+{
+    return _values.data();
+}
+
+const float* sim_env::WorldStateBuffer::data() const
+{
+    return _values.data();
+}
+
+Eigen::VectorXf& sim_env::WorldStateBuffer::getValues()
+{
+    return _values;
+}
+
+const Eigen::VectorXf& sim_env::WorldStateBuffer::getValues() const
+{
+    return _values;
+}
+
+Eigen::Map<Eigen::Vector3f> sim_env::WorldStateBuffer::getPosition(size_t object_idx)
+{
+    return Eigen::Map<Eigen::Vector3f>(_values.data() + getEntry(object_idx).offset);
+}
+
+Eigen::Map<const Eigen::Vector3f> sim_env::WorldStateBuffer::getPosition(size_t object_idx) const
+{
+    return Eigen::Map<const Eigen::Vector3f>(_values.data() + getEntry(object_idx).offset);
+}
+
+Eigen::Map<Eigen::Quaternionf> sim_env::WorldStateBuffer::getOrientation(size_t object_idx)
+{
+    // Eigen stores the coefficients of a quaternion in the order x, y, z, w
+    return Eigen::Map<Eigen::Quaternionf>(_values.data() + getEntry(object_idx).offset + 3);
+}
+
+Eigen::Map<const Eigen::Quaternionf> sim_env::WorldStateBuffer::getOrientation(size_t object_idx) const
+{
+    return Eigen::Map<const Eigen::Quaternionf>(_values.data() + getEntry(object_idx).offset + 3);
+}
+
+Eigen::Map<Eigen::VectorXf> sim_env::WorldStateBuffer::getDOFPositions(size_t object_idx)
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<Eigen::VectorXf>(_values.data() + entry.getPositionsOffset(), entry.num_dofs);
+}
+
+Eigen::Map<const Eigen::VectorXf> sim_env::WorldStateBuffer::getDOFPositions(size_t object_idx) const
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<const Eigen::VectorXf>(_values.data() + entry.getPositionsOffset(), entry.num_dofs);
+}
+
+Eigen::Map<Eigen::VectorXf> sim_env::WorldStateBuffer::getDOFVelocities(size_t object_idx)
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<Eigen::VectorXf>(_values.data() + entry.getVelocitiesOffset(), entry.num_dofs);
+}
+
+Eigen::Map<const Eigen::VectorXf> sim_env::WorldStateBuffer::getDOFVelocities(size_t object_idx) const
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<const Eigen::VectorXf>(_values.data() + entry.getVelocitiesOffset(), entry.num_dofs);
+}
+
+Eigen::Map<Eigen::VectorXf> sim_env::WorldStateBuffer::getObjectBlock(size_t object_idx)
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<Eigen::VectorXf>(_values.data() + entry.offset, entry.getSize());
+}
+
+Eigen::Map<const Eigen::VectorXf> sim_env::WorldStateBuffer::getObjectBlock(size_t object_idx) const
+{
+    auto& entry = getEntry(object_idx);
+    return Eigen::Map<const Eigen::VectorXf>(_values.data() + entry.offset, entry.getSize());
+}
+
+void sim_env::WorldStateBuffer::getPose(size_t object_idx, Eigen::Affine3f& pose) const
+{
+    pose.setIdentity();
+    pose.linear() = getOrientation(object_idx).toRotationMatrix();
+    pose.translation() = getPosition(object_idx);
+}
+
+void sim_env::WorldStateBuffer::setPose(size_t object_idx, const Eigen::Affine3f& pose)
+{
+    Eigen::Quaternionf rotation(pose.linear());
+    // q and -q represent the same rotation, store the one with w >= 0 so that equal poses have equal values
+    if (rotation.w() < 0.0f) {
+        rotation.coeffs() = -rotation.coeffs();
+    }
+    getOrientation(object_idx) = rotation;
+    getPosition(object_idx) = pose.translation();
+}
+
+void sim_env::WorldStateBuffer::getObjectState(size_t object_idx, ObjectState& object_state) const
+{
+    auto& entry = getEntry(object_idx);
+    getPose(object_idx, object_state.pose);
+    // assignments only reallocate if the sizes differ
+    object_state.dof_positions = getDOFPositions(object_idx);
+    object_state.dof_velocities = getDOFVelocities(object_idx);
+    object_state.active_dofs = entry.active_dofs;
+}
+
+void sim_env::WorldStateBuffer::setObjectState(size_t object_idx, const ObjectState& object_state)
+{
+    auto& entry = getEntry(object_idx);
+    if (object_state.dof_positions.size() != entry.num_dofs or object_state.dof_velocities.size() != entry.num_dofs) {
+        throw std::invalid_argument("[sim_env::WorldStateBuffer::setObjectState] "
+                                    "The number of DOFs of object "
+            + entry.name + " does not match the layout.");
+    }
+    setPose(object_idx, object_state.pose);
+    getDOFPositions(object_idx) = object_state.dof_positions;
+    getDOFVelocities(object_idx) = object_state.dof_velocities;
+}
+
+void sim_env::WorldStateBuffer::getWorldState(WorldState& state) const
+{
+    if (not _layout) {
+        state.clear();
+        return;
+    }
+    if (not hasObjects(state, *_layout)) {
+        state.clear();
+        for (auto& entry : _layout->getObjectEntries()) {
+            state[entry.name];
+        }
+    }
+    size_t object_idx = 0;
+    for (auto& state_pair : state) {
+        getObjectState(object_idx, state_pair.second);
+        ++object_idx;
+    }
+}
+
+void sim_env::WorldStateBuffer::setWorldState(const WorldState& state)
+{
+    if (not _layout or not hasObjects(state, *_layout)) {
+        throw std::invalid_argument("[sim_env::WorldStateBuffer::setWorldState] "
+                                    "The objects of the given state do not match the layout.");
+    }
+    size_t object_idx = 0;
+    for (auto& state_pair : state) {
+        setObjectState(object_idx, state_pair.second);
+        ++object_idx;
+    }
+}
+
+const WorldStateLayout::ObjectEntry& sim_env::WorldStateBuffer::getEntry(size_t object_idx) const
+{
+    if (not _layout) {
+        throw std::logic_error("[sim_env::WorldStateBuffer::getEntry] This buffer has no layout.");
+    }
+    return _layout->getObjectEntry(object_idx);
+}
+
+/************************************* WorldStateAccessor **************************************/
+sim_env::WorldStateAccessor::WorldStateAccessor(WorldPtr world, WorldStateLayoutConstPtr layout)
+    : _world(world)
+    , _layout(layout)
+{
+    if (not _layout) {
+        _layout = std::make_shared<WorldStateLayout>(WorldConstPtr(_world));
+    }
+    _objects.reserve(_layout->getNumObjects());
+    for (auto& entry : _layout->getObjectEntries()) {
+        ObjectPtr object = _world->getObject(entry.name, false);
+        if (not object) {
+            throw std::invalid_argument("[sim_env::WorldStateAccessor::WorldStateAccessor] "
+                                        "The world has no object "
+                + entry.name + ".");
+        }
+        if (object->getNumDOFs() != entry.num_dofs) {
+            throw std::invalid_argument("[sim_env::WorldStateAccessor::WorldStateAccessor] "
+                                        "The number of DOFs of object "
+                + entry.name + " does not match the layout.");
+        }
+        _objects.push_back(object);
+    }
+    _object_states.resize(_objects.size());
+}
+
+sim_env::WorldStateAccessor::~WorldStateAccessor() = default;
+
+WorldPtr sim_env::WorldStateAccessor::getWorld() const
+{
+    return _world;
+}
+
+WorldStateLayoutConstPtr sim_env::WorldStateAccessor::getLayout() const
+{
+    return _layout;
+}
+
+ObjectPtr sim_env::WorldStateAccessor::getObject(size_t object_idx) const
+{
+    return _objects.at(object_idx);
+}
+
+void sim_env::WorldStateAccessor::readState(WorldStateBuffer& buffer)
+{
+    if (buffer.getLayout() != _layout) {
+        buffer.setLayout(_layout);
+    }
+    std::lock_guard<std::recursive_mutex> lock(_world->getMutex());
+    for (size_t i = 0; i < _objects.size(); ++i) {
+        readObjectState(i, buffer);
+    }
+}
+
+void sim_env::WorldStateAccessor::writeState(const WorldStateBuffer& buffer)
+{
+    checkLayout(buffer);
+    std::lock_guard<std::recursive_mutex> lock(_world->getMutex());
+    for (size_t i = 0; i < _objects.size(); ++i) {
+        setObjectState(i, buffer);
+    }
+}
+
+void sim_env::WorldStateAccessor::readObjectState(size_t object_idx, WorldStateBuffer& buffer)
+{
+    if (buffer.getLayout() != _layout) {
+        buffer.setLayout(_layout);
+    }
+    ObjectState& object_state = _object_states.at(object_idx);
+    _objects[object_idx]->getState(object_state);
+    buffer.setObjectState(object_idx, object_state);
+}
+
+void sim_env::WorldStateAccessor::writeObjectState(size_t object_idx, const WorldStateBuffer& buffer)
+{
+    checkLayout(buffer);
+    setObjectState(object_idx, buffer);
+}
+
+void sim_env::WorldStateAccessor::setObjectState(size_t object_idx, const WorldStateBuffer& buffer)
+{
+    ObjectState& object_state = _object_states.at(object_idx);
+    buffer.getObjectState(object_idx, object_state);
+    // the active DOFs are not part of the buffer, keep the ones currently set on the object
+    object_state.active_dofs = _objects[object_idx]->getActiveDOFs();
+    _objects[object_idx]->setState(object_state);
+}
+
+void sim_env::WorldStateAccessor::checkLayout(const WorldStateBuffer& buffer) const
+{
+    // buffers with a different but compatible layout, e.g. created from a clone, are accepted as well
+    auto layout = buffer.getLayout();
+    if (layout != _layout and (not layout or not layout->isCompatible(*_layout))) {
+        throw std::invalid_argument("[sim_env::WorldStateAccessor::checkLayout] "
+                                    "The layout of the buffer does not match the layout of this accessor.");
+    }
+}
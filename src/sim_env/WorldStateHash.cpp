@@ -0,0 +1,322 @@
+//
+// Quantized hashing and deduplication of world states.
+//
+#include "sim_env/WorldStateHash.h"
+#include <algorithm>
+#include <cmath>
+#include <stdexcept>
+
+using namespace sim_env;
+
+namespace {
+// mixing constants of xxHash64
+const uint64_t PRIME_1 = 0x9E3779B185EBCA87ULL;
+const uint64_t PRIME_2 = 0xC2B2AE3D27D4EB4FULL;
+const uint64_t PRIME_3 = 0x165667B19E3779F9ULL;
+const uint64_t LANE_SEEDS[4] = { PRIME_1 + PRIME_2, PRIME_2, 0, 0 - PRIME_1 };
+// keys are clamped to this magnitude, so that the conversion to int64_t is defined
+const float MAX_KEY = 9.0e18f;
+// Reference quaternion (qx, qy, qz, qw) that selects the sign of orientations, normalized (1, 2, 4, 8).
+// No signed sum of its coefficients is zero, hence no axis-aligned rotation is orthogonal to it.
+const float REFERENCE_QUATERNION[4] = { 0.10846523f, 0.21693046f, 0.43386092f, 0.86772183f };
+
+inline uint64_t rotateLeft(uint64_t x, unsigned int r)
+{
+    return (x << r) | (x >> (64 - r));
+}
+
+inline uint64_t mixLane(uint64_t lane, int64_t key)
+{
+    lane += (uint64_t)key * PRIME_2;
+    return rotateLeft(lane, 31) * PRIME_1;
+}
+
+inline int64_t quantizeValue(float value, float inv_resolution)
+{
+    if (inv_resolution == 0.0f) {
+        return 0;
+    }
+    float scaled = std::max(-MAX_KEY, std::min(MAX_KEY, value * inv_resolution));
+    return (int64_t)std::floor(scaled);
+}
+
+/**
+ * Hashes the given keys. The keys are distributed round-robin over four independent lanes,
+ * so that the multiplications of consecutive keys do not form a single dependency chain.
+ */
+uint64_t hashKeys(const int64_t* keys, size_t num_keys)
+{
+    uint64_t lanes[4] = { LANE_SEEDS[0], LANE_SEEDS[1], LANE_SEEDS[2], LANE_SEEDS[3] };
+    size_t i = 0;
+    for (; i + 4 <= num_keys; i += 4) {
+        for (unsigned int l = 0; l < 4; ++l) {
+            lanes[l] = mixLane(lanes[l], keys[i + l]);
+        }
+    }
+    for (unsigned int l = 0; i < num_keys; ++i, ++l) {
+        lanes[l] = mixLane(lanes[l], keys[i]);
+    }
+    uint64_t hash = rotateLeft(lanes[0], 1) + rotateLeft(lanes[1], 7) + rotateLeft(lanes[2], 12)
+        + rotateLeft(lanes[3], 18) + (uint64_t)num_keys;
+    // final avalanche
+    hash ^= hash >> 33;
+    hash *= PRIME_2;
+    hash ^= hash >> 29;
+    hash *= PRIME_3;
+    hash ^= hash >> 32;
+    return hash;
+}
+
+size_t roundUpToPowerOfTwo(size_t n)
+{
+    size_t result = 1;
+    while (result < n) {
+        result <<= 1;
+    }
+    return result;
+}
+}
+
+/************************************* WorldStateHasher **************************************/
+sim_env::WorldStateHasher::WorldStateHasher(WorldStateLayoutConstPtr layout)
+    : _layout(layout)
+{
+    if (not _layout) {
+        throw std::invalid_argument("[sim_env::WorldStateHasher::WorldStateHasher] The layout must not be null.");
+    }
+    _inv_resolutions.setZero(_layout->getSize());
+    setPoseResolution(1e-3f, 1e-3f);
+    setDOFPositionResolution(1e-3f);
+}
+
+sim_env::WorldStateHasher::~WorldStateHasher() = default;
+
+WorldStateLayoutConstPtr sim_env::WorldStateHasher::getLayout() const
+{
+    return _layout;
+}
+
+void sim_env::WorldStateHasher::setPoseResolution(float position_resolution, float orientation_resolution)
+{
+    for (size_t i = 0; i < _layout->getNumObjects(); ++i) {
+        setPoseResolution(i, position_resolution, orientation_resolution);
+    }
+}
+
+void sim_env::WorldStateHasher::setDOFPositionResolution(float resolution)
+{
+    for (auto& entry : _layout->getObjectEntries()) {
+        setResolution(entry.getPositionsOffset(), entry.num_dofs, resolution);
+    }
+}
+
+void sim_env::WorldStateHasher::setDOFVelocityResolution(float resolution)
+{
+    for (auto& entry : _layout->getObjectEntries()) {
+        setResolution(entry.getVelocitiesOffset(), entry.num_dofs, resolution);
+    }
+}
+
+void sim_env::WorldStateHasher::setPoseResolution(size_t object_idx, float position_resolution,
+    float orientation_resolution)
+{
+    auto& entry = _layout->getObjectEntry(object_idx);
+    setResolution(entry.offset, 3, position_resolution);
+    setResolution(entry.offset + 3, 4, orientation_resolution);
+}
+
+void sim_env::WorldStateHasher::setDOFPositionResolution(size_t object_idx, unsigned int dof, float resolution)
+{
+    auto& entry = _layout->getObjectEntry(object_idx);
+    if (dof >= entry.num_dofs) {
+        throw std::out_of_range("[sim_env::WorldStateHasher::setDOFPositionResolution] Invalid DOF index.");
+    }
+    setResolution(entry.getPositionsOffset() + dof, 1, resolution);
+}
+
+void sim_env::WorldStateHasher::setDOFVelocityResolution(size_t object_idx, unsigned int dof, float resolution)
+{
+    auto& entry = _layout->getObjectEntry(object_idx);
+    if (dof >= entry.num_dofs) {
+        throw std::out_of_range("[sim_env::WorldStateHasher::setDOFVelocityResolution] Invalid DOF index.");
+    }
+    setResolution(entry.getVelocitiesOffset() + dof, 1, resolution);
+}
+
+void sim_env::WorldStateHasher::setResolutions(const Eigen::VectorXf& resolutions)
+{
+    if ((size_t)resolutions.size() != _layout->getSize()) {
+        throw std::invalid_argument("[sim_env::WorldStateHasher::setResolutions] "
+                                    "The number of resolutions does not match the layout.");
+    }
+    for (size_t i = 0; i < _layout->getSize(); ++i) {
+        setResolution(i, 1, resolutions[i]);
+    }
+}
+
+Eigen::VectorXf sim_env::WorldStateHasher::getResolutions() const
+{
+    Eigen::VectorXf resolutions(_inv_resolutions.size());
+    for (long i = 0; i < _inv_resolutions.size(); ++i) {
+        resolutions[i] = _inv_resolutions[i] == 0.0f ? 0.0f : 1.0f / _inv_resolutions[i];
+    }
+    return resolutions;
+}
+
+void sim_env::WorldStateHasher::quantize(const WorldStateBuffer& buffer, std::vector<int64_t>& keys) const
+{
+    checkBuffer(buffer);
+    keys.resize(buffer.size());
+    for (auto& entry : _layout->getObjectEntries()) {
+        quantizeObject(buffer.data() + entry.offset, entry, keys.data() + entry.offset);
+    }
+}
+
+uint64_t sim_env::WorldStateHasher::hash(const std::vector<int64_t>& keys) const
+{
+    return hashKeys(keys.data(), keys.size());
+}
+
+uint64_t sim_env::WorldStateHasher::hash(const WorldStateBuffer& buffer) const
+{
+    // reused by each thread, so that hashing does not allocate temporary memory
+    static thread_local std::vector<int64_t> keys;
+    quantize(buffer, keys);
+    return hash(keys);
+}
+
+uint64_t sim_env::WorldStateHasher::hash(const WorldState& state, WorldStateBuffer& scratch) const
+{
+    if (scratch.getLayout() != _layout) {
+        scratch.setLayout(_layout);
+    }
+    scratch.setWorldState(state);
+    return hash(scratch);
+}
+
+uint64_t sim_env::WorldStateHasher::hashObject(const WorldStateBuffer& buffer, size_t object_idx) const
+{
+    checkBuffer(buffer);
+    static thread_local std::vector<int64_t> keys;
+    auto& entry = _layout->getObjectEntry(object_idx);
+    keys.resize(entry.getSize());
+    quantizeObject(buffer.data() + entry.offset, entry, keys.data());
+    return hashKeys(keys.data(), keys.size());
+}
+
+bool sim_env::WorldStateHasher::equal(const WorldStateBuffer& a, const WorldStateBuffer& b) const
+{
+    static thread_local std::vector<int64_t> keys_a;
+    static thread_local std::vector<int64_t> keys_b;
+    quantize(a, keys_a);
+    quantize(b, keys_b);
+    return keys_a == keys_b;
+}
+
+void sim_env::WorldStateHasher::setResolution(size_t offset, size_t num_values, float resolution)
+{
+    if (resolution < 0.0f) {
+        throw std::invalid_argument("[sim_env::WorldStateHasher::setResolution] Resolutions must not be negative.");
+    }
+    _inv_resolutions.segment(offset, num_values).setConstant(resolution == 0.0f ? 0.0f : 1.0f / resolution);
+}
+
+void sim_env::WorldStateHasher::checkBuffer(const WorldStateBuffer& buffer) const
+{
+    if (buffer.size() != _layout->getSize()) {
+        throw std::invalid_argument("[sim_env::WorldStateHasher::checkBuffer] "
+                                    "The size of the buffer does not match the layout.");
+    }
+}
+
+void sim_env::WorldStateHasher::quantizeObject(const float* values, const WorldStateLayout::ObjectEntry& entry,
+    int64_t* keys) const
+{
+    const float* inv_resolutions = _inv_resolutions.data() + entry.offset;
+    const size_t size = entry.getSize();
+    for (size_t i = 0; i < size; ++i) {
+        keys[i] = quantizeValue(values[i], inv_resolutions[i]);
+    }
+    // q and -q are the same rotation, quantize the one on the side of the reference quaternion
+    const float* q = values + 3;
+    float dot = q[0] * REFERENCE_QUATERNION[0] + q[1] * REFERENCE_QUATERNION[1] + q[2] * REFERENCE_QUATERNION[2]
+        + q[3] * REFERENCE_QUATERNION[3];
+    if (dot < 0.0f) {
+        for (unsigned int i = 3; i < 7; ++i) {
+            keys[i] = quantizeValue(-values[i], inv_resolutions[i]);
+        }
+    }
+}
+
+/************************************* ConcurrentWorldStateSet **************************************/
+sim_env::ConcurrentWorldStateSet::ConcurrentWorldStateSet(WorldStateHasherConstPtr hasher, size_t num_shards)
+    : _hasher(hasher)
+    , _num_keys(hasher->getLayout()->getSize())
+    , _shard_mask(roundUpToPowerOfTwo(num_shards) - 1)
+    , _shards(_shard_mask + 1)
+{
+}
+
+sim_env::ConcurrentWorldStateSet::~ConcurrentWorldStateSet() = default;
+
+bool sim_env::ConcurrentWorldStateSet::insert(const WorldStateBuffer& buffer)
+{
+    // reused by each thread, so that insertions do not allocate temporary memory
+    static thread_local std::vector<int64_t> keys;
+    _hasher->quantize(buffer, keys);
+    uint64_t hash = _hasher->hash(keys);
+    // the low bits select the bucket within a shard, hence use the high bits to select the shard
+    Shard& shard = _shards[(hash >> 32) & _shard_mask];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    if (find(shard, hash, keys)) {
+        return false;
+    }
+    shard.entries.emplace(hash, shard.keys.size());
+    shard.keys.insert(shard.keys.end(), keys.begin(), keys.end());
+    return true;
+}
+
+bool sim_env::ConcurrentWorldStateSet::contains(const WorldStateBuffer& buffer) const
+{
+    static thread_local std::vector<int64_t> keys;
+    _hasher->quantize(buffer, keys);
+    uint64_t hash = _hasher->hash(keys);
+    const Shard& shard = _shards[(hash >> 32) & _shard_mask];
+    std::lock_guard<std::mutex> lock(shard.mutex);
+    return find(shard, hash, keys);
+}
+
+size_t sim_env::ConcurrentWorldStateSet::size() const
+{
+    size_t num_states = 0;
+    for (auto& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        num_states += shard.entries.size();
+    }
+    return num_states;
+}
+
+void sim_env::ConcurrentWorldStateSet::clear()
+{
+    for (auto& shard : _shards) {
+        std::lock_guard<std::mutex> lock(shard.mutex);
+        shard.entries.clear();
+        shard.keys.clear();
+    }
+}
+
+WorldStateHasherConstPtr sim_env::ConcurrentWorldStateSet::getHasher() const
+{
+    return _hasher;
+}
+
+bool sim_env::ConcurrentWorldStateSet::find(const Shard& shard, uint64_t hash, const std::vector<int64_t>& keys) const
+{
+    auto range = shard.entries.equal_range(hash);
+    for (auto iter = range.first; iter != range.second; ++iter) {
+        if (std::equal(keys.begin(), keys.end(), shard.keys.begin() + iter->second)) {
+            return true;
+        }
+    }
+    return false;
+}
@@ -0,0 +1,182 @@
+//
+// Copy-on-write stack of world states.
+//
+#include "sim_env/WorldStateStack.h"
+#include <algorithm>
+#include <stdexcept>
+
+using namespace sim_env;
+
+sim_env::WorldStateStack::WorldStateStack(WorldPtr world, WorldStateLayoutConstPtr layout)
+    : _accessor(std::make_shared<WorldStateAccessor>(world, layout))
+{
+    init();
+}
+
+sim_env::WorldStateStack::WorldStateStack(WorldStateAccessorPtr accessor)
+    : _accessor(accessor)
+{
+    if (not _accessor) {
+        throw std::invalid_argument("[sim_env::WorldStateStack::WorldStateStack] The accessor must not be null.");
+    }
+    init();
+}
+
+sim_env::WorldStateStack::~WorldStateStack() = default;
+
+void sim_env::WorldStateStack::saveState()
+{
+    if (_depth == _frames.size()) {
+        _frames.emplace_back();
+    }
+    Frame& frame = _frames[_depth];
+    frame.objects.clear();
+    frame.values.clear();
+    ++_depth;
+}
+
+bool sim_env::WorldStateStack::restoreState()
+{
+    if (_depth == 0) {
+        return false;
+    }
+    Frame& frame = _frames[_depth - 1];
+    {
+        std::lock_guard<std::recursive_mutex> lock(_accessor->getWorld()->getMutex());
+        for (auto& recorded : frame.objects) {
+            auto block = _scratch.getObjectBlock(recorded.object_idx);
+            block = Eigen::Map<const Eigen::VectorXf>(frame.values.data() + recorded.offset, block.size());
+            _accessor->writeObjectState(recorded.object_idx, _scratch);
+            _recorded_depths[recorded.object_idx] = recorded.prev_depth;
+        }
+    }
+    --_depth;
+    return true;
+}
+
+bool sim_env::WorldStateStack::dropState()
+{
+    if (_depth == 0) {
+        return false;
+    }
+    Frame& frame = _frames[_depth - 1];
+    if (_depth == 1) {
+        // there is no frame below, simply forget the recorded states
+        for (auto& recorded : frame.objects) {
+            _recorded_depths[recorded.object_idx] = 0;
+        }
+    } else {
+        Frame& below = _frames[_depth - 2];
+        for (auto& recorded : frame.objects) {
+            // objects that the frame below recorded already keep that (older) state,
+            // all others were unchanged between both saves and the recorded state is valid for the frame below
+            if (recorded.prev_depth != _depth - 1) {
+                record(below, recorded.object_idx, recorded.prev_depth, frame.values.data() + recorded.offset);
+            }
+            _recorded_depths[recorded.object_idx] = _depth - 1;
+        }
+    }
+    --_depth;
+    return true;
+}
+
+void sim_env::WorldStateStack::clear()
+{
+    _depth = 0;
+    std::fill(_recorded_depths.begin(), _recorded_depths.end(), 0);
+}
+
+void sim_env::WorldStateStack::touch(size_t object_idx)
+{
+    if (object_idx >= _recorded_depths.size()) {
+        throw std::out_of_range("[sim_env::WorldStateStack::touch] Invalid object index.");
+    }
+    if (_depth == 0 or _recorded_depths[object_idx] == _depth) {
+        return;
+    }
+    _accessor->readObjectState(object_idx, _scratch);
+    record(_frames[_depth - 1], object_idx, _recorded_depths[object_idx], _scratch.getObjectBlock(object_idx).data());
+    _recorded_depths[object_idx] = _depth;
+}
+
+void sim_env::WorldStateStack::touch(const std::string& name)
+{
+    int object_idx = _layout->getObjectIndex(name);
+    if (object_idx < 0) {
+        throw std::invalid_argument("[sim_env::WorldStateStack::touch] There is no object " + name + ".");
+    }
+    touch((size_t)object_idx);
+}
+
+void sim_env::WorldStateStack::touchAll()
+{
+    for (size_t i = 0; i < _recorded_depths.size(); ++i) {
+        touch(i);
+    }
+}
+
+bool sim_env::WorldStateStack::isTouched(size_t object_idx) const
+{
+    return _depth > 0 and _recorded_depths.at(object_idx) == _depth;
+}
+
+size_t sim_env::WorldStateStack::getDepth() const
+{
+    return _depth;
+}
+
+WorldStateAccessorPtr sim_env::WorldStateStack::getAccessor() const
+{
+    return _accessor;
+}
+
+size_t sim_env::WorldStateStack::getNumRecordedObjects() const
+{
+    size_t num_objects = 0;
+    for (size_t d = 0; d < _depth; ++d) {
+        num_objects += _frames[d].objects.size();
+    }
+    return num_objects;
+}
+
+size_t sim_env::WorldStateStack::getMemoryUsage() const
+{
+    size_t num_bytes = 0;
+    for (size_t d = 0; d < _depth; ++d) {
+        num_bytes += _frames[d].objects.size() * sizeof(RecordedObject) + _frames[d].values.size() * sizeof(float);
+    }
+    return num_bytes;
+}
+
+size_t sim_env::WorldStateStack::getReservedMemory() const
+{
+    size_t num_bytes = _frames.capacity() * sizeof(Frame) + _recorded_depths.capacity() * sizeof(size_t)
+        + _scratch.size() * sizeof(float);
+    for (auto& frame : _frames) {
+        num_bytes += frame.objects.capacity() * sizeof(RecordedObject) + frame.values.capacity() * sizeof(float);
+    }
+    return num_bytes;
+}
+
+size_t sim_env::WorldStateStack::getFullSnapshotMemoryUsage() const
+{
+    return _depth * _layout->getSize() * sizeof(float);
+}
+
+void sim_env::WorldStateStack::init()
+{
+    _layout = _accessor->getLayout();
+    _scratch.setLayout(_layout);
+    _depth = 0;
+    _recorded_depths.assign(_layout->getNumObjects(), 0);
+}
+
+void sim_env::WorldStateStack::record(Frame& frame, size_t object_idx, size_t prev_depth, const float* values)
+{
+    RecordedObject recorded;
+    recorded.object_idx = object_idx;
+    recorded.prev_depth = prev_depth;
+    recorded.offset = frame.values.size();
+    frame.values.insert(frame.values.end(), values, values + _layout->getObjectEntry(object_idx).getSize());
+    frame.objects.push_back(recorded);
+}
@@ -0,0 +1,145 @@
+//
+// Binary and memory mapped storage of grids.
+//
+
+#include <sim_env/grid/GridIO.h>
+#include <fcntl.h>
+#include <fstream>
+#include <sys/mman.h>
+#include <sys/stat.h>
+#include <unistd.h>
+#include <vector>
+
+using namespace sim_env::grid::grid_io;
+
+namespace {
+const char MAGIC[8] = { 'S', 'I', 'M', 'G', 'R', 'I', 'D', '\0' };
+}
+
+void sim_env::grid::grid_io::initHeader(FileHeader& header)
+{
+    std::memset(&header, 0, sizeof(FileHeader));
+    std::memcpy(header.magic, MAGIC, sizeof(MAGIC));
+    header.version = FORMAT_VERSION;
+    header.byte_order = BYTE_ORDER_MARK;
+    header.data_offset = alignOffset(sizeof(FileHeader));
+    header.transform[0] = header.transform[5] = header.transform[10] = header.transform[15] = 1.0;
+}
+
+void sim_env::grid::grid_io::writeFile(const std::string& path, const FileHeader& header, const void* data,
+    size_t num_bytes)
+{
+    writeFile(path, header, std::vector<DataBlock>(1, DataBlock{ data, num_bytes }));
+}
+
+void sim_env::grid::grid_io::writeFile(const std::string& path, const FileHeader& header,
+    const std::vector<DataBlock>& blocks)
+{
+    std::ofstream file(path, std::ios::binary | std::ios::trunc);
+    if (not file) {
+        throw std::runtime_error("[sim_env::grid::grid_io::writeFile] Could not open " + path + " for writing.");
+    }
+    file.write(reinterpret_cast<const char*>(&header), sizeof(FileHeader));
+    uint64_t position = sizeof(FileHeader);
+    uint64_t block_offset = header.data_offset;
+    std::vector<char> padding(DATA_ALIGNMENT, 0);
+    for (auto& block : blocks) {
+        file.write(padding.data(), block_offset - position);
+        if (block.num_bytes > 0) {
+            file.write(reinterpret_cast<const char*>(block.data), block.num_bytes);
+        }
+        position = block_offset + block.num_bytes;
+        block_offset = alignOffset(position);
+    }
+    file.close();
+    if (not file) {
+        throw std::runtime_error("[sim_env::grid::grid_io::writeFile] Failed to write " + path + ".");
+    }
+}
+
+void sim_env::grid::grid_io::checkHeader(const FileHeader& header, const std::string& path)
+{
+    if (std::memcmp(header.magic, MAGIC, sizeof(MAGIC)) != 0) {
+        throw std::runtime_error("[sim_env::grid::grid_io::checkHeader] The file " + path + " is not a grid file.");
+    }
+    if (header.byte_order != BYTE_ORDER_MARK) {
+        throw std::runtime_error("[sim_env::grid::grid_io::checkHeader] The file " + path
+            + " has been written on a machine with a different byte order.");
+    }
+    if (header.version != FORMAT_VERSION) {
+        throw std::runtime_error("[sim_env::grid::grid_io::checkHeader] The file " + path
+            + " has an unsupported format version " + std::to_string(header.version) + ".");
+    }
+    if (header.data_offset < sizeof(FileHeader) or header.data_offset % DATA_ALIGNMENT != 0) {
+        throw std::runtime_error("[sim_env::grid::grid_io::checkHeader] The file " + path + " is corrupted.");
+    }
+}
+
+FileHeader sim_env::grid::grid_io::readHeader(const std::string& path)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::runtime_error("[sim_env::grid::grid_io::readHeader] Could not open " + path + " for reading.");
+    }
+    FileHeader header;
+    if (not file.read(reinterpret_cast<char*>(&header), sizeof(FileHeader))) {
+        throw std::runtime_error("[sim_env::grid::grid_io::readHeader] The file " + path + " is not a grid file.");
+    }
+    checkHeader(header, path);
+    return header;
+}
+
+void sim_env::grid::grid_io::readData(const std::string& path, const FileHeader& header, void* data,
+    size_t num_bytes)
+{
+    std::ifstream file(path, std::ios::binary);
+    if (not file) {
+        throw std::runtime_error("[sim_env::grid::grid_io::readData] Could not open " + path + " for reading.");
+    }
+    file.seekg(header.data_offset);
+    if (num_bytes > 0 and not file.read(reinterpret_cast<char*>(data), num_bytes)) {
+        throw std::runtime_error("[sim_env::grid::grid_io::readData] The file " + path + " is truncated.");
+    }
+}
+
+sim_env::grid::grid_io::MappedFile::MappedFile(const std::string& path)
+    : _data(nullptr)
+    , _size(0)
+{
+    int fd = ::open(path.c_str(), O_RDONLY);
+    if (fd < 0) {
+        throw std::runtime_error("[sim_env::grid::grid_io::MappedFile] Could not open " + path + " for reading.");
+    }
+    struct stat file_stat;
+    if (::fstat(fd, &file_stat) != 0) {
+        ::close(fd);
+        throw std::runtime_error("[sim_env::grid::grid_io::MappedFile] Could not determine the size of " + path + ".");
+    }
+    _size = (size_t)file_stat.st_size;
+    if (_size > 0) {
+        _data = ::mmap(nullptr, _size, PROT_READ, MAP_SHARED, fd, 0);
+    }
+    // the mapping stays valid after closing the file descriptor
+    ::close(fd);
+    if (_data == MAP_FAILED) {
+        _data = nullptr;
+        throw std::runtime_error("[sim_env::grid::grid_io::MappedFile] Could not map " + path + ".");
+    }
+}
+
+sim_env::grid::grid_io::MappedFile::~MappedFile()
+{
+    if (_data) {
+        ::munmap(_data, _size);
+    }
+}
+
+const char* sim_env::grid::grid_io::MappedFile::getData() const
+{
+    return reinterpret_cast<const char*>(_data);
+}
+
+size_t sim_env::grid::grid_io::MappedFile::getSize() const
+{
+    return _size;
+}
@@ -0,0 +1,218 @@
+//
+// Log-odds occupancy mapping on voxel grids.
+//
+
+#include <sim_env/grid/OccupancyGrid.h>
+#include <sim_env/grid/ConcurrentGrid3D.h>
+#include <sim_env/grid/RayCasting.h>
+#include <sim_env/utils/MathUtils.h>
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <cmath>
+#include <limits>
+#include <mutex>
+#include <stdexcept>
+
+using namespace sim_env::grid;
+
+namespace {
+// Number of rays that are traversed as one chunk by insertRays.
+const size_t RAY_CHUNK_SIZE = 64;
+// Number of touched cells that are updated as one chunk by insertRays.
+const size_t UPDATE_CHUNK_SIZE = 4096;
+
+// Marks the given cell in the stamp grid of the current batch. The flat index of the cell is appended to
+// touched_cells if this is the first time the cell is touched in this batch.
+inline void markCell(ConcurrentGrid3D<uint32_t>& stamps, uint32_t batch, const UnsignedIndex& idx, bool hit,
+    std::vector<size_t>& touched_cells)
+{
+    uint32_t old_stamp = stamps.atomicMax(idx, 2 * batch + (hit ? 1 : 0));
+    if (old_stamp < 2 * batch) {
+        touched_cells.push_back(stamps.getGrid().getFlatIndex(idx));
+    }
+}
+
+// Marks all cells traversed by the given ray as free and the cell containing the endpoint as hit.
+void collectCells(const VoxelGrid<float, float>& grid, const OccupancyGrid::Parameters& params,
+    ConcurrentGrid3D<uint32_t>& stamps, uint32_t batch, const Eigen::Vector3f& origin,
+    const Eigen::Vector3f& endpoint, std::vector<size_t>& touched_cells)
+{
+    Eigen::Vector3f direction = endpoint - origin;
+    float length = direction.norm();
+    float max_distance = length;
+    bool has_hit = true;
+    if (params.max_range >= 0.0f and length > params.max_range) {
+        max_distance = params.max_range;
+        has_hit = false;
+    }
+    UnsignedIndex hit_idx;
+    bool hit_valid = false;
+    if (has_hit) {
+        Eigen::Vector3f coordinates = grid.getMapping().getCellCoordinates(endpoint);
+        SignedIndex idx((long)std::floor(coordinates[0]), (long)std::floor(coordinates[1]),
+            (long)std::floor(coordinates[2]));
+        hit_valid = grid.inBounds(idx);
+        hit_idx = idx.toUnsignedIndex();
+    }
+    if (length > 0.0f) {
+        traverseRay(grid, origin, direction, max_distance, [&](const UnsignedIndex& idx, float, float) {
+            if (not(hit_valid and hit_idx == idx)) {
+                markCell(stamps, batch, idx, false, touched_cells);
+            }
+            return true;
+        });
+    }
+    if (hit_valid) {
+        markCell(stamps, batch, hit_idx, true, touched_cells);
+    }
+}
+}
+
+OccupancyGrid::OccupancyGrid(const Eigen::Vector3f& min_point, const Eigen::Vector3f& max_point, float cell_size,
+    const Parameters& params)
+    : _grid(min_point, max_point, cell_size, 0.0f)
+    , _params(params)
+    , _stamps(_grid.getXSize(), _grid.getYSize(), _grid.getZSize(), 0)
+    , _batch(0)
+    , _dirty_flags(_grid.getXSize(), _grid.getYSize(), _grid.getZSize(), 0)
+{
+    if (params.min_log_odds > 0.0f or params.max_log_odds < 0.0f) {
+        throw std::invalid_argument("[sim_env::grid::OccupancyGrid::OccupancyGrid] The log-odds bounds must "
+                                    "contain 0.");
+    }
+}
+
+void OccupancyGrid::insertRays(const Eigen::Matrix3Xf& origins, const Eigen::Matrix3Xf& endpoints,
+    unsigned int num_threads)
+{
+    if (origins.cols() != 1 and origins.cols() != endpoints.cols()) {
+        throw std::invalid_argument("[sim_env::grid::OccupancyGrid::insertRays] There must be either a single "
+                                    "origin or one origin per ray.");
+    }
+    nextBatch();
+    // 1. traverse all rays and collect each touched cell once
+    ConcurrentGrid3D<uint32_t> stamps(_stamps, 3, 1);
+    std::vector<size_t> touched_cells;
+    std::mutex mutex;
+    sim_env::utils::parallel::parallelFor(0, endpoints.cols(), [&](size_t begin, size_t end) {
+        std::vector<size_t> local_cells;
+        for (size_t i = begin; i < end; ++i) {
+            Eigen::Vector3f origin = origins.col(origins.cols() == 1 ? 0 : i);
+            Eigen::Vector3f endpoint = endpoints.col(i);
+            collectCells(_grid, _params, stamps, _batch, origin, endpoint, local_cells);
+        }
+        std::lock_guard<std::mutex> lock(mutex);
+        touched_cells.insert(touched_cells.end(), local_cells.begin(), local_cells.end());
+    }, num_threads, RAY_CHUNK_SIZE);
+    // 2. update each touched cell; since every cell occurs once, no synchronization is needed
+    sim_env::utils::parallel::parallelFor(0, touched_cells.size(), [&](size_t begin, size_t end) {
+        std::vector<UnsignedIndex> local_dirty_cells;
+        updateCells(touched_cells, begin, end, local_dirty_cells);
+        std::lock_guard<std::mutex> lock(mutex);
+        _dirty_cells.insert(_dirty_cells.end(), local_dirty_cells.begin(), local_dirty_cells.end());
+    }, num_threads, UPDATE_CHUNK_SIZE);
+}
+
+void OccupancyGrid::insertRay(const Eigen::Vector3f& origin, const Eigen::Vector3f& endpoint)
+{
+    insertRays(Eigen::Matrix3Xf(origin), Eigen::Matrix3Xf(endpoint), 1);
+}
+
+float OccupancyGrid::getLogOdds(const UnsignedIndex& idx) const
+{
+    return _grid.at(idx);
+}
+
+float OccupancyGrid::getProbability(const UnsignedIndex& idx) const
+{
+    return 1.0f - 1.0f / (1.0f + std::exp(_grid.at(idx)));
+}
+
+bool OccupancyGrid::isOccupied(const UnsignedIndex& idx) const
+{
+    return _grid.at(idx) > _params.occupied_log_odds;
+}
+
+const VoxelGrid<float, float>& OccupancyGrid::getGrid() const
+{
+    return _grid;
+}
+
+void OccupancyGrid::setTransform(const Eigen::Affine3f& tf)
+{
+    _grid.setTransform(tf);
+}
+
+const OccupancyGrid::Parameters& OccupancyGrid::getParameters() const
+{
+    return _params;
+}
+
+const std::vector<UnsignedIndex>& OccupancyGrid::getDirtyCells() const
+{
+    return _dirty_cells;
+}
+
+void OccupancyGrid::takeDirtyCells(std::vector<UnsignedIndex>& cells)
+{
+    cells.clear();
+    cells.swap(_dirty_cells);
+    for (auto& idx : cells) {
+        _dirty_flags(idx) = 0;
+    }
+}
+
+void OccupancyGrid::clearDirtyCells()
+{
+    for (auto& idx : _dirty_cells) {
+        _dirty_flags(idx) = 0;
+    }
+    _dirty_cells.clear();
+}
+
+void OccupancyGrid::clear()
+{
+    for (size_t flat_index = 0; flat_index < _grid.getStorageSize(); ++flat_index) {
+        if (_grid[flat_index] != 0.0f) {
+            _grid[flat_index] = 0.0f;
+            markDirty(flat_index, _dirty_cells);
+        }
+    }
+}
+
+void OccupancyGrid::nextBatch()
+{
+    // stamps of older batches must remain smaller than 2 * _batch
+    if (_batch >= std::numeric_limits<uint32_t>::max() / 2 - 1) {
+        std::fill(_stamps.begin(), _stamps.end(), 0);
+        _batch = 0;
+    }
+    ++_batch;
+}
+
+void OccupancyGrid::updateCells(const std::vector<size_t>& touched_cells, size_t begin, size_t end,
+    std::vector<UnsignedIndex>& dirty_cells)
+{
+    for (size_t i = begin; i < end; ++i) {
+        size_t flat_index = touched_cells[i];
+        bool hit = (_stamps[flat_index] & 1) != 0;
+        float old_value = _grid[flat_index];
+        float new_value = sim_env::utils::math::clamp(
+            old_value + (hit ? _params.hit_log_odds : _params.miss_log_odds), _params.min_log_odds,
+            _params.max_log_odds);
+        if (new_value != old_value) {
+            _grid[flat_index] = new_value;
+            markDirty(flat_index, dirty_cells);
+        }
+    }
+}
+
+void OccupancyGrid::markDirty(size_t flat_index, std::vector<UnsignedIndex>& dirty_cells)
+{
+    if (_dirty_flags[flat_index] == 0) {
+        _dirty_flags[flat_index] = 1;
+        size_t xy_size = _grid.getXSize() * _grid.getYSize();
+        dirty_cells.push_back(UnsignedIndex(flat_index % _grid.getXSize(),
+            (flat_index % xy_size) / _grid.getXSize(), flat_index / xy_size));
+    }
+}
@@ -0,0 +1,213 @@
+//
+// Rasterization of link and object geometries into voxel grids.
+//
+
+#include <sim_env/grid/Voxelization.h>
+#include <algorithm>
+#include <cmath>
+
+using namespace sim_env::grid;
+
+namespace {
+// Tests whether the projections of the triangle and the box onto the given axis are separated.
+inline bool isSeparatingAxis(const Eigen::Vector3f& axis, const Eigen::Vector3f& half_size,
+    const Eigen::Vector3f& v0, const Eigen::Vector3f& v1, const Eigen::Vector3f& v2)
+{
+    float p0 = axis.dot(v0);
+    float p1 = axis.dot(v1);
+    float p2 = axis.dot(v2);
+    float radius = half_size.dot(axis.cwiseAbs());
+    return std::min(p0, std::min(p1, p2)) > radius or std::max(p0, std::max(p1, p2)) < -radius;
+}
+
+// Returns the range of cell indices along one axis that overlap [min_coord, max_coord] clamped to [0, size).
+// Returns false if the range is empty.
+inline bool getCellRange(float min_coord, float max_coord, size_t size, size_t& begin, size_t& end)
+{
+    if (max_coord < 0.0f or min_coord >= (float)size) {
+        return false;
+    }
+    begin = (size_t)std::max(0.0f, std::floor(min_coord));
+    end = std::min(size, (size_t)std::floor(max_coord) + 1);
+    return begin < end;
+}
+}
+
+bool sim_env::grid::voxelization::triangleBoxOverlap(const Eigen::Vector3f& box_center,
+    const Eigen::Vector3f& box_half_size,
+    const Eigen::Vector3f& v0, const Eigen::Vector3f& v1, const Eigen::Vector3f& v2)
+{
+    // move the box to the origin
+    const Eigen::Vector3f a = v0 - box_center;
+    const Eigen::Vector3f b = v1 - box_center;
+    const Eigen::Vector3f c = v2 - box_center;
+    // face normals of the box, i.e. the aabb of the triangle
+    for (unsigned int d = 0; d < 3; ++d) {
+        if (std::min(a[d], std::min(b[d], c[d])) > box_half_size[d]
+            or std::max(a[d], std::max(b[d], c[d])) < -box_half_size[d]) {
+            return false;
+        }
+    }
+    // normal of the triangle
+    const Eigen::Vector3f edges[3] = { b - a, c - b, a - c };
+    Eigen::Vector3f normal = edges[0].cross(edges[1]);
+    if (isSeparatingAxis(normal, box_half_size, a, b, c)) {
+        return false;
+    }
+    // cross products of the triangle edges with the box axes
+    for (unsigned int e = 0; e < 3; ++e) {
+        for (unsigned int d = 0; d < 3; ++d) {
+            Eigen::Vector3f axis = Eigen::Vector3f::Unit(d).cross(edges[e]);
+            if (axis.squaredNorm() > 0.0f and isSeparatingAxis(axis, box_half_size, a, b, c)) {
+                return false;
+            }
+        }
+    }
+    return true;
+}
+
+void sim_env::grid::voxelization::transformToCells(const Geometry& geometry, const Eigen::Affine3f& tf,
+    const VoxelGridMapping<float>& mapping, std::vector<Eigen::Vector3f>& vertices)
+{
+    Eigen::Matrix<float, 3, 4> world_to_cell = mapping.getWorldToCellMatrix();
+    Eigen::Matrix3f rotation = world_to_cell.block<3, 3>(0, 0) * tf.linear();
+    Eigen::Vector3f translation = world_to_cell.block<3, 3>(0, 0) * tf.translation() + world_to_cell.col(3);
+    vertices.resize(geometry.vertices.size());
+    for (size_t i = 0; i < vertices.size(); ++i) {
+        vertices[i] = rotation * geometry.vertices[i] + translation;
+    }
+}
+
+void sim_env::grid::voxelization::rasterizeTriangles(const std::vector<Eigen::Vector3f>& vertices,
+    const std::vector<std::tuple<unsigned int, unsigned int, unsigned int>>& triangles, size_t begin, size_t end,
+    const std::array<size_t, 3>& num_cells, std::vector<UnsignedIndex>& cells)
+{
+    // in cell coordinates each cell is a unit cube; inflate slightly to be conservative w.r.t. rounding
+    const Eigen::Vector3f half_size = Eigen::Vector3f::Constant(0.5f + 1e-4f);
+    for (size_t t = begin; t < end; ++t) {
+        auto& triangle = triangles[t];
+        const Eigen::Vector3f& v0 = vertices.at(std::get<0>(triangle));
+        const Eigen::Vector3f& v1 = vertices.at(std::get<1>(triangle));
+        const Eigen::Vector3f& v2 = vertices.at(std::get<2>(triangle));
+        Eigen::Vector3f min_corner = v0.cwiseMin(v1).cwiseMin(v2);
+        Eigen::Vector3f max_corner = v0.cwiseMax(v1).cwiseMax(v2);
+        size_t cell_begin[3], cell_end[3];
+        bool empty = false;
+        for (unsigned int d = 0; d < 3; ++d) {
+            empty = empty or not getCellRange(min_corner[d], max_corner[d], num_cells[d], cell_begin[d], cell_end[d]);
+        }
+        if (empty) continue;
+        for (size_t z = cell_begin[2]; z < cell_end[2]; ++z) {
+            for (size_t y = cell_begin[1]; y < cell_end[1]; ++y) {
+                for (size_t x = cell_begin[0]; x < cell_end[0]; ++x) {
+                    Eigen::Vector3f center(x + 0.5f, y + 0.5f, z + 0.5f);
+                    if (voxelization::triangleBoxOverlap(center, half_size, v0, v1, v2)) {
+                        cells.push_back(UnsignedIndex(x, y, z));
+                    }
+                }
+            }
+        }
+    }
+}
+
+void sim_env::grid::voxelization::rasterizePolygon(const std::vector<Eigen::Vector3f>& vertices,
+    const std::array<size_t, 3>& num_cells, std::vector<UnsignedIndex>& cells)
+{
+    if (vertices.size() < 3) return;
+    float min_z = vertices[0].z(), max_z = vertices[0].z();
+    float min_y = vertices[0].y(), max_y = vertices[0].y();
+    for (auto& vertex : vertices) {
+        min_z = std::min(min_z, vertex.z());
+        max_z = std::max(max_z, vertex.z());
+        min_y = std::min(min_y, vertex.y());
+        max_y = std::max(max_y, vertex.y());
+    }
+    size_t z_begin, z_end, y_begin, y_end;
+    if (not getCellRange(min_z, max_z, num_cells[2], z_begin, z_end)) return;
+    if (not getCellRange(min_y, max_y, num_cells[1], y_begin, y_end)) return;
+    const size_t num_vertices = vertices.size();
+    std::vector<char> row(num_cells[0]);
+    std::vector<float> crossings;
+    for (size_t y = y_begin; y < y_end; ++y) {
+        std::fill(row.begin(), row.end(), 0);
+        const float row_min = (float)y;
+        const float row_max = row_min + 1.0f;
+        const float row_center = row_min + 0.5f;
+        crossings.clear();
+        for (size_t i = 0; i < num_vertices; ++i) {
+            const Eigen::Vector3f& p = vertices[i];
+            const Eigen::Vector3f& q = vertices[(i + 1) % num_vertices];
+            // cells touched by the part of the edge within this row
+            float edge_min_y = std::min(p.y(), q.y());
+            float edge_max_y = std::max(p.y(), q.y());
+            if (edge_max_y >= row_min and edge_min_y <= row_max) {
+                float x_a, x_b;
+                if (edge_max_y == edge_min_y) {
+                    x_a = p.x();
+                    x_b = q.x();
+                } else {
+                    float inv_dy = 1.0f / (q.y() - p.y());
+                    float t_a = std::min(std::max((row_min - p.y()) * inv_dy, 0.0f), 1.0f);
+                    float t_b = std::min(std::max((row_max - p.y()) * inv_dy, 0.0f), 1.0f);
+                    x_a = p.x() + t_a * (q.x() - p.x());
+                    x_b = p.x() + t_b * (q.x() - p.x());
+                }
+                size_t x_begin, x_end;
+                if (getCellRange(std::min(x_a, x_b), std::max(x_a, x_b), num_cells[0], x_begin, x_end)) {
+                    std::fill(row.begin() + x_begin, row.begin() + x_end, 1);
+                }
+            }
+            // crossings of the edge with the scan line through the cell centers (even-odd rule)
+            if ((p.y() <= row_center) != (q.y() <= row_center)) {
+                float t = (row_center - p.y()) / (q.y() - p.y());
+                crossings.push_back(p.x() + t * (q.x() - p.x()));
+            }
+        }
+        // cells whose centers are inside of the polygon
+        std::sort(crossings.begin(), crossings.end());
+        for (size_t c = 0; c + 1 < crossings.size(); c += 2) {
+            size_t x_begin, x_end;
+            if (getCellRange(std::ceil(crossings[c] - 0.5f), std::floor(crossings[c + 1] - 0.5f), num_cells[0],
+                    x_begin, x_end)) {
+                std::fill(row.begin() + x_begin, row.begin() + x_end, 1);
+            }
+        }
+        for (size_t x = 0; x < num_cells[0]; ++x) {
+            if (not row[x]) continue;
+            for (size_t z = z_begin; z < z_end; ++z) {
+                cells.push_back(UnsignedIndex(x, y, z));
+            }
+        }
+    }
+}
+
+void sim_env::grid::voxelization::rasterizeGeometry(const Geometry& geometry, const Eigen::Affine3f& tf,
+    const VoxelGridMapping<float>& mapping, std::vector<UnsignedIndex>& cells)
+{
+    // transform all vertices to cell coordinates, in which each cell is a unit cube
+    std::vector<Eigen::Vector3f> vertices;
+    transformToCells(geometry, tf, mapping, vertices);
+    if (geometry.is_polygon) {
+        rasterizePolygon(vertices, mapping.getNumCells(), cells);
+    } else {
+        rasterizeTriangles(vertices, geometry.triangles, 0, geometry.triangles.size(), mapping.getNumCells(), cells);
+    }
+}
+
+void sim_env::grid::voxelization::collectGeometries(LinkConstPtr link, std::vector<Geometry>& geometries,
+    std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f>>& transforms)
+{
+    std::vector<Geometry> link_geometries = link->getGeometries();
+    geometries.insert(geometries.end(), link_geometries.begin(), link_geometries.end());
+    transforms.resize(geometries.size(), link->getTransform());
+}
+
+void sim_env::grid::voxelization::collectGeometries(ObjectConstPtr object, std::vector<Geometry>& geometries,
+    std::vector<Eigen::Affine3f, Eigen::aligned_allocator<Eigen::Affine3f>>& transforms)
+{
+    std::vector<LinkConstPtr> links;
+    object->getLinks(links);
+    for (auto& link : links) {
+        collectGeometries(link, geometries, transforms);
+    }
+}
@@ -0,0 +1,151 @@
+//
+// Utilities to distribute work over multiple threads.
+//
+
+#include <sim_env/utils/ParallelUtils.h>
+#include <algorithm>
+#include <atomic>
+#include <exception>
+#include <memory>
+
+using namespace sim_env::utils::parallel;
+
+sim_env::utils::parallel::ThreadPool::ThreadPool(unsigned int num_threads)
+    : _stop(false)
+{
+    if (num_threads == 0) {
+        num_threads = std::max(1u, std::thread::hardware_concurrency());
+    }
+    for (unsigned int i = 0; i < num_threads; ++i) {
+        _workers.emplace_back(&ThreadPool::work, this);
+    }
+}
+
+sim_env::utils::parallel::ThreadPool::~ThreadPool()
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _stop = true;
+    }
+    _condition.notify_all();
+    for (auto& worker : _workers) {
+        worker.join();
+    }
+}
+
+void sim_env::utils::parallel::ThreadPool::submit(std::function<void()> task)
+{
+    {
+        std::lock_guard<std::mutex> lock(_mutex);
+        _tasks.push_back(std::move(task));
+    }
+    _condition.notify_one();
+}
+
+unsigned int sim_env::utils::parallel::ThreadPool::getNumThreads() const
+{
+    return (unsigned int)_workers.size();
+}
+
+ThreadPool& sim_env::utils::parallel::ThreadPool::getDefaultPool()
+{
+    // this is thread safe in C++11
+    static ThreadPool pool;
+    return pool;
+}
+
+void sim_env::utils::parallel::ThreadPool::work()
+{
+    while (true) {
+        std::function<void()> task;
+        {
+            std::unique_lock<std::mutex> lock(_mutex);
+            _condition.wait(lock, [this] { return _stop or not _tasks.empty(); });
+            if (_stop and _tasks.empty()) {
+                return;
+            }
+            task = std::move(_tasks.front());
+            _tasks.pop_front();
+        }
+        task();
+    }
+}
+
+namespace {
+// State shared between the caller of parallelFor and the helper tasks. Helpers may start after
+// the caller has already returned, hence the state is reference counted.
+struct ParallelForState {
+    std::function<void(size_t, size_t)> fn;
+    size_t begin;
+    size_t end;
+    size_t chunk_size;
+    size_t num_chunks;
+    std::atomic<size_t> next_chunk;
+    std::atomic<size_t> finished_chunks;
+    std::mutex mutex;
+    std::condition_variable done_condition;
+    std::exception_ptr exception;
+
+    // Processes chunks until there are no more left.
+    void run()
+    {
+        size_t chunk;
+        while ((chunk = next_chunk++) < num_chunks) {
+            size_t chunk_begin = begin + chunk * chunk_size;
+            size_t chunk_end = std::min(end, chunk_begin + chunk_size);
+            try {
+                fn(chunk_begin, chunk_end);
+            } catch (...) {
+                std::lock_guard<std::mutex> lock(mutex);
+                if (not exception) {
+                    exception = std::current_exception();
+                }
+            }
+            if (++finished_chunks == num_chunks) {
+                std::lock_guard<std::mutex> lock(mutex);
+                done_condition.notify_all();
+            }
+        }
+    }
+};
+}
+
+void sim_env::utils::parallel::parallelFor(size_t begin, size_t end, const std::function<void(size_t, size_t)>& fn,
+    unsigned int num_threads, size_t min_chunk_size)
+{
+    if (end <= begin) {
+        return;
+    }
+    ThreadPool& pool = ThreadPool::getDefaultPool();
+    // the calling thread works as well
+    unsigned int max_threads = pool.getNumThreads() + 1;
+    num_threads = num_threads == 0 ? max_threads : std::min(num_threads, max_threads);
+    size_t range = end - begin;
+    min_chunk_size = std::max(min_chunk_size, size_t(1));
+    if (num_threads == 1 or range <= min_chunk_size) {
+        fn(begin, end);
+        return;
+    }
+    // use a few chunks per thread to balance uneven work loads
+    size_t chunk_size = std::max(min_chunk_size, (range + 4 * num_threads - 1) / (4 * num_threads));
+    auto state = std::make_shared<ParallelForState>();
+    state->fn = fn;
+    state->begin = begin;
+    state->end = end;
+    state->chunk_size = chunk_size;
+    state->num_chunks = (range + chunk_size - 1) / chunk_size;
+    state->next_chunk = 0;
+    state->finished_chunks = 0;
+    size_t num_helpers = std::min<size_t>(num_threads - 1, state->num_chunks - 1);
+    for (size_t i = 0; i < num_helpers; ++i) {
+        pool.submit([state] { state->run(); });
+    }
+    state->run();
+    {
+        std::unique_lock<std::mutex> lock(state->mutex);
+        state->done_condition.wait(lock, [&state] { return state->finished_chunks == state->num_chunks; });
+    }
+    if (state->exception) {
+        std::rethrow_exception(state->exception);
+    }
+}
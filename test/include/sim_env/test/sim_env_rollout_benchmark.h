@@ -0,0 +1,94 @@
+//
+// This header contains a generic rollout throughput benchmark for sim_env::World implementations.
+// sim_env itself contains no physics engine, hence the benchmark is run by the packages that implement World.
+//
+
+#ifndef SIM_ENV_SIM_ENV_ROLLOUT_BENCHMARK_H
+#define SIM_ENV_SIM_ENV_ROLLOUT_BENCHMARK_H
+#include <algorithm>
+#include <cstdio>
+#include <memory>
+#include <random>
+#include <sim_env/RolloutExecutor.h>
+#include <sim_env/SimEnv.h>
+#include <sim_env/WorldPool.h>
+#include <stdexcept>
+#include <string>
+#include <vector>
+
+namespace sim_env {
+    namespace test {
+        struct RolloutBenchmarkSettings {
+            std::string robot_name; // robot to control
+            sim_env::RolloutExecutor::InputMode mode;
+            sim_env::RolloutExecutor::ControllerFactory controller_factory; // required for InputMode::Target
+            std::vector<unsigned int> thread_counts; // thread counts to sweep over
+            unsigned int num_rollouts; // rollouts per measurement
+            unsigned int num_actions; // actions per rollout
+            unsigned int steps_per_action; // physics steps per action
+            float input_magnitude; // inputs are sampled uniformly from [-input_magnitude, input_magnitude]
+            unsigned int repetitions; // the fastest of this many measurements is reported
+            RolloutBenchmarkSettings() : mode(sim_env::RolloutExecutor::InputMode::Raw),
+                                         thread_counts({1, 2, 4, 8}),
+                                         num_rollouts(256), num_actions(10), steps_per_action(10),
+                                         input_magnitude(0.1f), repetitions(3) {}
+        };
+
+        struct RolloutBenchmarkResult {
+            unsigned int num_threads;
+            float rollouts_per_second;
+        };
+
+        /**
+         * Measures the throughput of a RolloutExecutor on clones of the given world for each of the
+         * thread counts in settings. The world is cloned once per thread of the largest thread count.
+         * The results are printed to stdout and returned.
+         */
+        inline std::vector<RolloutBenchmarkResult> benchmarkRollouts(sim_env::WorldPtr world,
+                                                                     const RolloutBenchmarkSettings& settings) {
+            sim_env::RobotPtr robot = world->getRobot(settings.robot_name);
+            if (not robot) {
+                throw std::invalid_argument("[sim_env::test::benchmarkRollouts] There is no robot " +
+                                            settings.robot_name + ".");
+            }
+            unsigned int max_threads = 1;
+            for (unsigned int num_threads : settings.thread_counts) {
+                max_threads = std::max(max_threads, num_threads);
+            }
+            auto pool = std::make_shared<sim_env::WorldPool>(world, max_threads);
+            sim_env::RolloutExecutor executor(pool, settings.robot_name, settings.mode, settings.controller_factory);
+            // random inputs, the same for all thread counts
+            std::mt19937 generator(0);
+            std::uniform_real_distribution<float> distribution(-settings.input_magnitude, settings.input_magnitude);
+            std::vector<sim_env::ActionSequence> sequences(settings.num_rollouts);
+            for (auto& sequence : sequences) {
+                for (unsigned int a = 0; a < settings.num_actions; ++a) {
+                    Eigen::VectorXf input(robot->getNumActiveDOFs());
+                    for (long i = 0; i < input.size(); ++i) {
+                        input[i] = distribution(generator);
+                    }
+                    sequence.push_back(sim_env::RolloutAction(input, settings.steps_per_action));
+                }
+            }
+            std::vector<sim_env::RolloutResult> results;
+            std::vector<RolloutBenchmarkResult> benchmark_results;
+            std::printf("rollouts: %u rollouts of %u x %u steps, %u worlds\n", settings.num_rollouts,
+                        settings.num_actions, settings.steps_per_action, pool->getNumWorlds());
+            for (unsigned int num_threads : settings.thread_counts) {
+                RolloutBenchmarkResult result{num_threads, 0.0f};
+                for (unsigned int r = 0; r < std::max(settings.repetitions, 1u); ++r) {
+                    executor.execute(sequences, results, num_threads);
+                    result.rollouts_per_second = std::max(result.rollouts_per_second,
+                                                          executor.getLastRolloutsPerSecond());
+                }
+                std::printf("  %2u threads %10.1f rollouts/s %12.0f steps/s\n", num_threads,
+                            result.rollouts_per_second,
+                            result.rollouts_per_second * settings.num_actions * settings.steps_per_action);
+                benchmark_results.push_back(result);
+            }
+            return benchmark_results;
+        }
+    }
+}
+
+#endif //SIM_ENV_SIM_ENV_ROLLOUT_BENCHMARK_H